@@ -0,0 +1,114 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Monotonic memory arena: memory is handed out by bumping a pointer through large blocks, and is only given back when
+ * the whole arena is destroyed. Allocating is a few instructions, and freeing thousands of objects is freeing a handful
+ * of blocks.
+ *
+ * Objects allocated in the arena must still have their destructors called, but whatever they deallocate is simply
+ * abandoned, so objects whose memory grows repeatedly (e.g. vectors filled one element at a time) should reserve their
+ * final size up front.
+ */
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reserve(size_t bytes);
+    size_t numBlocks() const;
+private:
+    // Size of the blocks allocated when nothing was reserved
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* top = nullptr;
+    char* end = nullptr;
+
+    void newBlock(size_t bytes);
+};
+
+/**
+ * @brief Allocates memory for an object, from the current block if it has room for it, or from a new block otherwise.
+ * @param alignment     alignment of the object, no greater than the alignment of std::max_align_t
+ */
+inline void* Arena::allocate(size_t bytes, size_t alignment) {
+    uintptr_t address = (reinterpret_cast<uintptr_t>(top) + alignment - 1) & ~(alignment - 1);
+    if (top == nullptr || address + bytes > reinterpret_cast<uintptr_t>(end)) {
+        size_t blockSize = DEFAULT_BLOCK_SIZE;
+        if (bytes > blockSize) {
+            blockSize = bytes;
+        }
+        newBlock(blockSize);
+        address = reinterpret_cast<uintptr_t>(top);
+    }
+
+    top = reinterpret_cast<char*>(address + bytes);
+    return reinterpret_cast<void*>(address);
+}
+
+/**
+ * @brief Makes sure the following allocations, up to the given number of bytes (including the padding between
+ * objects), are placed contiguously in a single block.
+ */
+inline void Arena::reserve(size_t bytes) {
+    if (top == nullptr || static_cast<size_t>(end - top) < bytes) {
+        newBlock(bytes);
+    }
+}
+
+inline size_t Arena::numBlocks() const {
+    return blocks.size();
+}
+
+inline void Arena::newBlock(size_t bytes) {
+    blocks.emplace_back(new char[bytes]);
+    top = blocks.back().get();
+    end = top + bytes;
+}
+
+
+/**
+ * Standard allocator handing out memory from an Arena, so containers (e.g. the adjacency vectors of a graph) can be
+ * placed in it. Deallocation does nothing.
+ */
+template <class U>
+class ArenaAllocator {
+public:
+    using value_type = U;
+
+    explicit ArenaAllocator(Arena* arena) : arena(arena) {}
+
+    template <class V>
+    ArenaAllocator(const ArenaAllocator<V>& other) : arena(other.arena) {}
+
+    U* allocate(size_t n) {
+        return static_cast<U*>(arena->allocate(n * sizeof(U), alignof(U)));
+    }
+
+    void deallocate(U*, size_t) {}
+
+    template <class V>
+    bool operator==(const ArenaAllocator<V>& other) const {
+        return arena == other.arena;
+    }
+
+    template <class V>
+    bool operator!=(const ArenaAllocator<V>& other) const {
+        return arena != other.arena;
+    }
+
+    template <class V>
+    friend class ArenaAllocator;
+private:
+    Arena* arena;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,568 @@
+#include "ContractionHierarchy.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+static const float INF = std::numeric_limits<float>::max();
+
+// Maximum number of vertices settled by a witness search when contracting a vertex and when estimating its priority.
+// Stopping early only adds unnecessary shortcuts, it never makes queries incorrect.
+static const size_t CONTRACTION_SETTLED_LIMIT = 500;
+static const size_t PRIORITY_SETTLED_LIMIT = 50;
+
+namespace {
+    // Edge of the graph being contracted, as seen from one of its endpoints
+    struct DynamicEdge {
+        uint32_t other;
+        float weight;
+        uint32_t middle;
+    };
+
+    struct Shortcut {
+        uint32_t from, to;
+        float weight;
+    };
+
+    /**
+     * Graph being contracted, with both the outgoing and the incoming edges of every vertex. Edges from and to
+     * contracted vertices are removed, so the lists only hold the remaining graph.
+     */
+    class Contractor {
+    public:
+        explicit Contractor(const CsrGraph& graph);
+
+        void findShortcuts(uint32_t v, size_t settledLimit, std::vector<Shortcut>& shortcuts);
+        int priority(uint32_t v);
+        void contract(uint32_t v, std::vector<DynamicEdge>& upwardEdges, std::vector<DynamicEdge>& downwardEdges);
+    private:
+        std::vector<std::vector<DynamicEdge>> out, in;
+        std::vector<uint32_t> deletedNeighbours;
+        // Upper bound of the number of hierarchy levels below each vertex
+        std::vector<uint32_t> level;
+
+        // State of the witness searches, kept between searches to avoid reallocating it
+        std::vector<float> witnessDist;
+        std::vector<uint8_t> witnessTarget;
+        std::vector<uint32_t> touched;
+        std::vector<std::pair<float, uint32_t>> witnessHeap;
+        std::vector<Shortcut> shortcutBuffer;
+
+        static void addOrImproveEdge(std::vector<DynamicEdge>& edges, uint32_t other, float weight, uint32_t middle);
+        static void removeEdge(std::vector<DynamicEdge>& edges, uint32_t other);
+        void witnessSearch(uint32_t source, uint32_t skipped, float maxDist, size_t targets, size_t settledLimit);
+    };
+
+    Contractor::Contractor(const CsrGraph& graph) :
+            out(graph.numVertices()), in(graph.numVertices()), deletedNeighbours(graph.numVertices(), 0),
+            level(graph.numVertices(), 0),
+            witnessDist(graph.numVertices(), INF), witnessTarget(graph.numVertices(), 0) {
+        for (uint32_t v = 0; v < graph.numVertices(); ++v) {
+            for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+                uint32_t w = graph.dest[e];
+                if (w == v)
+                    continue;
+                addOrImproveEdge(out[v], w, graph.weight[e], NO_VERTEX);
+                addOrImproveEdge(in[w], v, graph.weight[e], NO_VERTEX);
+            }
+        }
+    }
+
+    /**
+     * @brief Keeps a single edge to each neighbour, with the minimum weight.
+     */
+    void Contractor::addOrImproveEdge(std::vector<DynamicEdge>& edges, uint32_t other, float weight, uint32_t middle) {
+        for (DynamicEdge& edge : edges) {
+            if (edge.other == other) {
+                if (weight < edge.weight) {
+                    edge.weight = weight;
+                    edge.middle = middle;
+                }
+                return;
+            }
+        }
+        edges.push_back({other, weight, middle});
+    }
+
+    void Contractor::removeEdge(std::vector<DynamicEdge>& edges, uint32_t other) {
+        for (size_t i = 0; i < edges.size(); ++i) {
+            if (edges[i].other == other) {
+                edges[i] = edges.back();
+                edges.pop_back();
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Dijkstra search in the remaining graph without the skipped vertex, limited to paths no longer than maxDist
+     * and to settledLimit settled vertices, which stops once the vertices marked in witnessTarget are settled. Leaves
+     * the distances in witnessDist (the caller must reset the touched vertices afterwards).
+     * @param targets   number of marked vertices
+     */
+    void Contractor::witnessSearch(uint32_t source, uint32_t skipped, float maxDist, size_t targets,
+                                   size_t settledLimit) {
+        std::greater<std::pair<float, uint32_t>> compare;
+        witnessHeap.clear();
+
+        witnessDist[source] = 0;
+        touched.push_back(source);
+        witnessHeap.push_back({0, source});
+
+        size_t settled = 0;
+        while (!witnessHeap.empty() && settled < settledLimit && targets > 0) {
+            std::pop_heap(witnessHeap.begin(), witnessHeap.end(), compare);
+            std::pair<float, uint32_t> entry = witnessHeap.back();
+            witnessHeap.pop_back();
+
+            uint32_t v = entry.second;
+            if (entry.first > witnessDist[v])
+                continue; // stale entry
+            if (entry.first > maxDist)
+                break;
+            ++settled;
+            targets -= witnessTarget[v];
+
+            for (const DynamicEdge& edge : out[v]) {
+                if (edge.other == skipped)
+                    continue;
+                float newDist = entry.first + edge.weight;
+                if (newDist < witnessDist[edge.other]) {
+                    if (witnessDist[edge.other] == INF) {
+                        touched.push_back(edge.other);
+                    }
+                    witnessDist[edge.other] = newDist;
+                    witnessHeap.push_back({newDist, edge.other});
+                    std::push_heap(witnessHeap.begin(), witnessHeap.end(), compare);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Finds the shortcuts that contracting a vertex requires: one for every pair of neighbours u -> v -> w
+     * without a path (a witness) avoiding v which is no longer than the path through v.
+     */
+    void Contractor::findShortcuts(uint32_t v, size_t settledLimit, std::vector<Shortcut>& shortcuts) {
+        shortcuts.clear();
+
+        for (const DynamicEdge& outEdge : out[v]) {
+            witnessTarget[outEdge.other] = 1;
+        }
+
+        for (const DynamicEdge& inEdge : in[v]) {
+            uint32_t u = inEdge.other;
+
+            float maxDist = -1;
+            for (const DynamicEdge& outEdge : out[v]) {
+                if (outEdge.other != u) {
+                    maxDist = std::max(maxDist, inEdge.weight + outEdge.weight);
+                }
+            }
+            if (maxDist < 0)
+                continue; // v only leads back to u
+
+            witnessSearch(u, v, maxDist, out[v].size(), settledLimit);
+
+            for (const DynamicEdge& outEdge : out[v]) {
+                float viaDist = inEdge.weight + outEdge.weight;
+                if (outEdge.other != u && witnessDist[outEdge.other] > viaDist) {
+                    shortcuts.push_back({u, outEdge.other, viaDist});
+                }
+            }
+
+            for (uint32_t w : touched) {
+                witnessDist[w] = INF;
+            }
+            touched.clear();
+        }
+
+        for (const DynamicEdge& outEdge : out[v]) {
+            witnessTarget[outEdge.other] = 0;
+        }
+    }
+
+    /**
+     * @brief Priority of a vertex in the contraction order (lower is contracted first): the edge difference (number of
+     * shortcuts added minus number of edges removed), plus the number of neighbours already contracted and the level of
+     * the vertex, which spread the contraction uniformly over the graph and keep the hierarchy shallow.
+     */
+    int Contractor::priority(uint32_t v) {
+        findShortcuts(v, PRIORITY_SETTLED_LIMIT, shortcutBuffer);
+        int edgeDifference = static_cast<int>(shortcutBuffer.size()) - static_cast<int>(in[v].size() + out[v].size());
+        return 2 * edgeDifference + static_cast<int>(deletedNeighbours[v]) + static_cast<int>(level[v]);
+    }
+
+    /**
+     * @brief Removes a vertex from the remaining graph, adding the required shortcuts.
+     * @param upwardEdges       filled with the edges leaving the vertex
+     * @param downwardEdges     filled with the edges entering the vertex
+     */
+    void Contractor::contract(uint32_t v, std::vector<DynamicEdge>& upwardEdges,
+                              std::vector<DynamicEdge>& downwardEdges) {
+        findShortcuts(v, CONTRACTION_SETTLED_LIMIT, shortcutBuffer);
+
+        upwardEdges = out[v];
+        downwardEdges = in[v];
+
+        for (const DynamicEdge& edge : out[v]) {
+            removeEdge(in[edge.other], v);
+            ++deletedNeighbours[edge.other];
+            level[edge.other] = std::max(level[edge.other], level[v] + 1);
+        }
+        for (const DynamicEdge& edge : in[v]) {
+            removeEdge(out[edge.other], v);
+            ++deletedNeighbours[edge.other];
+            level[edge.other] = std::max(level[edge.other], level[v] + 1);
+        }
+        out[v].clear();
+        in[v].clear();
+
+        for (const Shortcut& shortcut : shortcutBuffer) {
+            addOrImproveEdge(out[shortcut.from], shortcut.to, shortcut.weight, v);
+            addOrImproveEdge(in[shortcut.to], shortcut.from, shortcut.weight, v);
+        }
+    }
+
+    /**
+     * @brief Packs the edge lists of every vertex into a CSR graph and a parallel array of middle vertices.
+     */
+    void packEdges(const std::vector<std::vector<DynamicEdge>>& edges, CsrGraph& graph, std::vector<uint32_t>& middle) {
+        graph.clear();
+        middle.clear();
+        graph.offsets.push_back(0);
+
+        for (const std::vector<DynamicEdge>& vertexEdges : edges) {
+            for (const DynamicEdge& edge : vertexEdges) {
+                graph.dest.push_back(edge.other);
+                graph.weight.push_back(edge.weight);
+                middle.push_back(edge.middle);
+            }
+            graph.offsets.push_back(graph.dest.size());
+        }
+    }
+}
+
+/**
+ * @brief Builds the hierarchy, contracting the vertices in order of priority. Priorities are updated lazily: the
+ * vertex at the top of the queue has its priority recalculated, and is only contracted if it is still the minimum.
+ * @param graph     graph to preprocess
+ */
+ContractionHierarchy::ContractionHierarchy(const CsrGraph& graph) :
+        rank(graph.numVertices()), originalEdges(graph.numEdges()), originalFingerprint(graph.fingerprint()) {
+    const uint32_t n = graph.numVertices();
+    Contractor contractor(graph);
+
+    using QueueEntry = std::pair<int, uint32_t>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    for (uint32_t v = 0; v < n; ++v) {
+        queue.push({contractor.priority(v), v});
+    }
+
+    std::vector<std::vector<DynamicEdge>> upwardEdges(n), downwardEdges(n);
+    uint32_t nextRank = 0;
+
+    while (!queue.empty()) {
+        uint32_t v = queue.top().second;
+        queue.pop();
+
+        int newPriority = contractor.priority(v);
+        if (!queue.empty() && newPriority > queue.top().first) {
+            queue.push({newPriority, v});
+            continue;
+        }
+
+        rank[v] = nextRank++;
+        contractor.contract(v, upwardEdges[v], downwardEdges[v]);
+    }
+
+    packEdges(upwardEdges, upward, upwardMiddle);
+    packEdges(downwardEdges, downward, downwardMiddle);
+
+    shortcuts = 0;
+    for (uint32_t middle : upwardMiddle) {
+        shortcuts += middle != NO_VERTEX;
+    }
+    for (uint32_t middle : downwardMiddle) {
+        shortcuts += middle != NO_VERTEX;
+    }
+}
+
+uint32_t ContractionHierarchy::numVertices() const {
+    return rank.size();
+}
+
+uint32_t ContractionHierarchy::numShortcuts() const {
+    return shortcuts;
+}
+
+uint32_t ContractionHierarchy::getRank(uint32_t v) const {
+    return rank[v];
+}
+
+/**
+ * @brief Checks if the hierarchy may have been built from a graph (i.e. it has the same number of vertices and edges,
+ * and the same fingerprint). Updating or removing any edge makes the hierarchy stale, so it must be built again. The
+ * fingerprint is the one kept by the graph, so the check takes constant time.
+ */
+bool ContractionHierarchy::matches(const CsrGraph& graph) const {
+    return numVertices() == graph.numVertices() && originalEdges == graph.numEdges() &&
+           originalFingerprint == graph.fingerprint();
+}
+
+const CsrGraph& ContractionHierarchy::getUpwardGraph() const {
+    return upward;
+}
+
+const CsrGraph& ContractionHierarchy::getDownwardGraph() const {
+    return downward;
+}
+
+/**
+ * @brief Calculates the shortest path between two vertices with a bidirectional search in the hierarchy. Each
+ * direction stops when its minimum key is no smaller than the best path found.
+ * @param source        index of the source vertex
+ * @param target        index of the target vertex
+ * @param forward       workspace of the forward (upward) search
+ * @param backward      workspace of the backward (downward) search
+ * @param path          if not null, filled with the indices of the vertices of the unpacked path, from the source to
+ * the target (empty if there is no path)
+ * @return              distance from the source to the target (MAX_FLOAT if unreachable)
+ */
+float ContractionHierarchy::query(uint32_t source, uint32_t target, SearchWorkspace& forward,
+                                  SearchWorkspace& backward, std::vector<uint32_t>* path) const {
+    const uint32_t n = numVertices();
+    forward.reset(n);
+    backward.reset(n);
+
+    forward.setDist(source, 0, NO_VERTEX);
+    forward.queue.insert(source);
+    backward.setDist(target, 0, NO_VERTEX);
+    backward.queue.insert(target);
+
+    float best = INF;
+    uint32_t meeting = NO_VERTEX;
+
+    while (!forward.queue.empty() || !backward.queue.empty()) {
+        bool forwardStep = !forward.queue.empty() && (backward.queue.empty() ||
+                forward.dist[forward.queue.top()] <= backward.dist[backward.queue.top()]);
+
+        SearchWorkspace& workspace = forwardStep ? forward : backward;
+        const SearchWorkspace& other = forwardStep ? backward : forward;
+        const CsrGraph& graph = forwardStep ? upward : downward;
+
+        uint32_t v = workspace.queue.top();
+        float vDist = workspace.dist[v];
+        if (vDist >= best) {
+            workspace.queue.clear();
+            continue;
+        }
+        workspace.queue.extractMin();
+
+        if (other.reached(v) && vDist + other.getDist(v) < best) {
+            best = vDist + other.getDist(v);
+            meeting = v;
+        }
+
+        for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+            uint32_t w = graph.dest[e];
+            float newDist = vDist + graph.weight[e];
+
+            if (workspace.getDist(w) > newDist) {
+                bool notInQueue = !workspace.reached(w);
+                workspace.setDist(w, newDist, v);
+
+                if (notInQueue) {
+                    workspace.queue.insert(w);
+                }
+                else {
+                    workspace.queue.decreaseKey(w);
+                }
+            }
+        }
+    }
+
+    if (path != nullptr) {
+        path->clear();
+
+        if (meeting != NO_VERTEX) {
+            std::vector<uint32_t> upwardPart;
+            for (uint32_t v = meeting; v != NO_VERTEX; v = forward.getPred(v)) {
+                upwardPart.push_back(v);
+            }
+            std::reverse(upwardPart.begin(), upwardPart.end());
+
+            path->push_back(source);
+            for (size_t i = 1; i < upwardPart.size(); ++i) {
+                unpackEdge(upwardPart[i - 1], upwardPart[i], *path);
+            }
+            for (uint32_t v = meeting; backward.getPred(v) != NO_VERTEX; v = backward.getPred(v)) {
+                unpackEdge(v, backward.getPred(v), *path);
+            }
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Finds the edge of the hierarchy between two vertices, which is stored with the endpoint of lower rank.
+ * @param middle    set to the vertex skipped by the edge (NO_VERTEX if it is an edge of the original graph)
+ * @return          true if the edge exists
+ */
+bool ContractionHierarchy::findEdge(uint32_t from, uint32_t to, uint32_t& middle) const {
+    if (rank[from] < rank[to]) {
+        for (uint32_t e = upward.edgesBegin(from); e < upward.edgesEnd(from); ++e) {
+            if (upward.dest[e] == to) {
+                middle = upwardMiddle[e];
+                return true;
+            }
+        }
+    }
+    else {
+        for (uint32_t e = downward.edgesBegin(to); e < downward.edgesEnd(to); ++e) {
+            if (downward.dest[e] == from) {
+                middle = downwardMiddle[e];
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Unpacks an edge of the hierarchy into the edges of the original graph, recursively replacing each shortcut by
+ * the two edges it skips.
+ * @param path      path where the vertices after the first one are appended (from is assumed to already be there)
+ */
+void ContractionHierarchy::unpackEdge(uint32_t from, uint32_t to, std::vector<uint32_t>& path) const {
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{from, to}};
+
+    while (!stack.empty()) {
+        std::pair<uint32_t, uint32_t> edge = stack.back();
+        stack.pop_back();
+
+        uint32_t middle = NO_VERTEX;
+        findEdge(edge.first, edge.second, middle);
+
+        if (middle == NO_VERTEX) {
+            path.push_back(edge.second);
+        }
+        else {
+            // The first half goes on top of the stack, so that it is unpacked first
+            stack.push_back({middle, edge.second});
+            stack.push_back({edge.first, middle});
+        }
+    }
+}
+
+// Identifies serialized hierarchies ("CH" and a format version)
+static const uint32_t FILE_MAGIC = 0x43480002;
+
+template <class E>
+static void writeVector(std::ofstream& ofs, const std::vector<E>& vector) {
+    uint64_t size = vector.size();
+    ofs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    ofs.write(reinterpret_cast<const char*>(vector.data()), size * sizeof(E));
+}
+
+/**
+ * @brief Reads a vector written by writeVector. Its size is checked against the bytes left in the file before anything
+ * is allocated, so a corrupted size fails the read instead of requesting a huge amount of memory.
+ * @param fileSize  size of the whole file, in bytes
+ */
+template <class E>
+static bool readVector(std::ifstream& ifs, uint64_t fileSize, std::vector<E>& vector) {
+    uint64_t size;
+    if (!ifs.read(reinterpret_cast<char*>(&size), sizeof(size)))
+        return false;
+    uint64_t remaining = fileSize - static_cast<uint64_t>(ifs.tellg());
+    if (size > remaining / sizeof(E))
+        return false;
+    vector.resize(size);
+    return static_cast<bool>(ifs.read(reinterpret_cast<char*>(vector.data()), size * sizeof(E)));
+}
+
+/**
+ * @brief Checks that a graph of a hierarchy read from a file is consistent: its offsets start at 0, never decrease and
+ * end at the number of edges, it has one weight and one middle vertex per edge, and its destinations and middle
+ * vertices are vertices of the hierarchy (or NO_VERTEX, for the middle vertices of original edges).
+ * @param numVertices   number of vertices of the hierarchy
+ */
+static bool isValidGraph(const CsrGraph& graph, const std::vector<uint32_t>& middle, uint32_t numVertices) {
+    if (graph.numVertices() != numVertices || graph.offsets[0] != 0 || graph.offsets.back() != graph.dest.size() ||
+        graph.weight.size() != graph.dest.size() || middle.size() != graph.dest.size())
+        return false;
+
+    for (uint32_t v = 0; v < numVertices; ++v) {
+        if (graph.offsets[v] > graph.offsets[v + 1])
+            return false;
+    }
+    return std::all_of(graph.dest.begin(), graph.dest.end(), [numVertices](uint32_t v) {
+        return v < numVertices;
+    }) && std::all_of(middle.begin(), middle.end(), [numVertices](uint32_t v) {
+        return v < numVertices || v == NO_VERTEX;
+    });
+}
+
+/**
+ * @brief Writes the hierarchy to a binary file, so that preprocessing only has to be done once per map.
+ * @return  true if the file was written successfully
+ */
+bool ContractionHierarchy::save(const std::string& path) const {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs)
+        return false;
+
+    ofs.write(reinterpret_cast<const char*>(&FILE_MAGIC), sizeof(FILE_MAGIC));
+    ofs.write(reinterpret_cast<const char*>(&originalEdges), sizeof(originalEdges));
+    ofs.write(reinterpret_cast<const char*>(&originalFingerprint), sizeof(originalFingerprint));
+    ofs.write(reinterpret_cast<const char*>(&shortcuts), sizeof(shortcuts));
+    writeVector(ofs, rank);
+    writeVector(ofs, upward.offsets);
+    writeVector(ofs, upward.dest);
+    writeVector(ofs, upward.weight);
+    writeVector(ofs, upwardMiddle);
+    writeVector(ofs, downward.offsets);
+    writeVector(ofs, downward.dest);
+    writeVector(ofs, downward.weight);
+    writeVector(ofs, downwardMiddle);
+
+    return static_cast<bool>(ofs);
+}
+
+/**
+ * @brief Reads a hierarchy written by save. Queries index the arrays with each other, so a file whose arrays are not
+ * consistent (see isValidGraph) is rejected, even if it still matches the graph.
+ * @return  true if the file was read successfully (otherwise, the hierarchy is left empty)
+ */
+bool ContractionHierarchy::load(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    uint64_t fileSize = ifs ? static_cast<uint64_t>(ifs.tellg()) : 0;
+    ifs.seekg(0);
+    uint32_t magic = 0;
+
+    bool success = ifs.read(reinterpret_cast<char*>(&magic), sizeof(magic)) && magic == FILE_MAGIC &&
+            ifs.read(reinterpret_cast<char*>(&originalEdges), sizeof(originalEdges)) &&
+            ifs.read(reinterpret_cast<char*>(&originalFingerprint), sizeof(originalFingerprint)) &&
+            ifs.read(reinterpret_cast<char*>(&shortcuts), sizeof(shortcuts)) &&
+            readVector(ifs, fileSize, rank) &&
+            readVector(ifs, fileSize, upward.offsets) && readVector(ifs, fileSize, upward.dest) &&
+            readVector(ifs, fileSize, upward.weight) && readVector(ifs, fileSize, upwardMiddle) &&
+            readVector(ifs, fileSize, downward.offsets) && readVector(ifs, fileSize, downward.dest) &&
+            readVector(ifs, fileSize, downward.weight) && readVector(ifs, fileSize, downwardMiddle) &&
+            rank.size() < NO_VERTEX && !upward.offsets.empty() && !downward.offsets.empty();
+
+    const uint32_t n = rank.size();
+    success = success && std::all_of(rank.begin(), rank.end(), [n](uint32_t r) {
+        return r < n;
+    }) && isValidGraph(upward, upwardMiddle, n) && isValidGraph(downward, downwardMiddle, n);
+
+    if (!success) {
+        *this = ContractionHierarchy();
+    }
+    return success;
+}
@@ -0,0 +1,63 @@
+#ifndef CONTRACTION_HIERARCHY_H
+#define CONTRACTION_HIERARCHY_H
+
+#include "CsrGraph.h"
+#include "SearchWorkspace.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Contraction Hierarchy (CH) over a CSR graph, for fast exact point to point shortest path queries.
+ *
+ * Preprocessing contracts the vertices one by one, in order of importance (least important first). Contracting a
+ * vertex removes it from the remaining graph, adding a shortcut edge u -> w for every path u -> v -> w that is the only
+ * shortest path between its endpoints. The rank of a vertex is its position in the contraction order.
+ *
+ * Every shortest path then has an equivalent path which first only goes up in rank and then only goes down, so a query
+ * is a bidirectional search where both directions only follow edges to vertices of higher rank, settling a tiny
+ * fraction of the graph. Shortcuts remember the vertex they skip, so paths are unpacked back into original edges.
+ *
+ * Vertices are identified by the same dense indices as in the CSR graph the hierarchy was built from.
+ */
+class ContractionHierarchy {
+public:
+    ContractionHierarchy() = default;
+    explicit ContractionHierarchy(const CsrGraph& graph);
+
+    uint32_t numVertices() const;
+    uint32_t numShortcuts() const;
+    uint32_t getRank(uint32_t v) const;
+    bool matches(const CsrGraph& graph) const;
+
+    const CsrGraph& getUpwardGraph() const;
+    const CsrGraph& getDownwardGraph() const;
+
+    float query(uint32_t source, uint32_t target, SearchWorkspace& forward, SearchWorkspace& backward,
+                std::vector<uint32_t>* path = nullptr) const;
+    void unpackEdge(uint32_t from, uint32_t to, std::vector<uint32_t>& path) const;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+private:
+    std::vector<uint32_t> rank;
+
+    // Edges from each vertex to vertices of higher rank, followed by forward searches
+    CsrGraph upward;
+    // Edges into each vertex from vertices of higher rank, reversed, followed by backward searches
+    CsrGraph downward;
+    // Vertex skipped by each edge of the upward and downward graphs (NO_VERTEX for edges of the original graph)
+    std::vector<uint32_t> upwardMiddle;
+    std::vector<uint32_t> downwardMiddle;
+
+    // Size and fingerprint of the graph the hierarchy was built from, used to detect stale hierarchies (e.g. serialized
+    // before the map changed, or built before an edge weight was updated)
+    uint32_t originalEdges = 0;
+    uint64_t originalFingerprint = 0;
+    uint32_t shortcuts = 0;
+
+    bool findEdge(uint32_t from, uint32_t to, uint32_t& middle) const;
+};
+
+#endif // CONTRACTION_HIERARCHY_H
@@ -0,0 +1,159 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Sentinel index meaning "no vertex", e.g. the predecessor of a search source
+constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+/**
+ * Frozen compressed sparse row (CSR) representation of a graph with weighted directed edges, with weights of type W
+ * (see WeightTraits).
+ *
+ * Vertices are identified by dense indices in [0, numVertices()). The outgoing edges of vertex v are stored
+ * contiguously in the positions [offsets[v], offsets[v + 1]) of the dest and weight arrays, so scanning the
+ * adjacency of a vertex is a sequential read of two packed arrays.
+ */
+template <class W>
+struct BasicCsrGraph {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> dest;
+    std::vector<W> weight;
+
+    uint32_t numVertices() const;
+    uint32_t numEdges() const;
+
+    uint32_t edgesBegin(uint32_t v) const;
+    uint32_t edgesEnd(uint32_t v) const;
+
+    uint64_t fingerprint() const;
+    void updateFingerprint();
+    void setWeight(uint32_t e, W newWeight);
+    void clear();
+private:
+    // Kept by updateFingerprint and setWeight, so that checking it costs nothing
+    uint64_t storedFingerprint = 0;
+
+    static uint64_t edgeHash(uint32_t e, uint32_t dest, W weight);
+};
+
+// The graphs the contraction hierarchy, the landmarks and the row cache are built on
+using CsrGraph = BasicCsrGraph<float>;
+
+template <class W>
+inline uint32_t BasicCsrGraph<W>::numVertices() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+}
+
+template <class W>
+inline uint32_t BasicCsrGraph<W>::numEdges() const {
+    return dest.size();
+}
+
+template <class W>
+inline uint32_t BasicCsrGraph<W>::edgesBegin(uint32_t v) const {
+    return offsets[v];
+}
+
+template <class W>
+inline uint32_t BasicCsrGraph<W>::edgesEnd(uint32_t v) const {
+    return offsets[v + 1];
+}
+
+/**
+ * @brief Returns the hash of the structure and the weights of the graph stored by updateFingerprint, so that data
+ * derived from it can tell whether an edge was updated since, even if the graph kept its size.
+ */
+template <class W>
+inline uint64_t BasicCsrGraph<W>::fingerprint() const {
+    return storedFingerprint;
+}
+
+/**
+ * @brief Hashes the arrays of the graph: FNV-1a over the offsets plus the sum of a hash of each edge. Must be called
+ * after the arrays are filled; changing a weight afterwards goes through setWeight, which keeps the hash up to date.
+ */
+template <class W>
+inline void BasicCsrGraph<W>::updateFingerprint() {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint32_t offset : offsets) {
+        for (int byte = 0; byte < 4; ++byte) {
+            hash = (hash ^ ((offset >> (8 * byte)) & 0xFF)) * 1099511628211ULL;
+        }
+    }
+    for (uint32_t e = 0; e < dest.size(); ++e) {
+        hash += edgeHash(e, dest[e], weight[e]);
+    }
+    storedFingerprint = hash;
+}
+
+/**
+ * @brief Changes the weight of an edge, replacing its term in the fingerprint (the edges are summed, so this does not
+ * rehash the graph).
+ */
+template <class W>
+inline void BasicCsrGraph<W>::setWeight(uint32_t e, W newWeight) {
+    storedFingerprint += edgeHash(e, dest[e], newWeight) - edgeHash(e, dest[e], weight[e]);
+    weight[e] = newWeight;
+}
+
+/**
+ * @brief Mixes the position, destination and weight of an edge into 64 bits (with the finalizer of splitmix64).
+ */
+template <class W>
+inline uint64_t BasicCsrGraph<W>::edgeHash(uint32_t e, uint32_t dest, W weight) {
+    static_assert(sizeof(W) <= sizeof(uint64_t), "Weights are hashed by their bits");
+    uint64_t bits = 0;
+    std::memcpy(&bits, &weight, sizeof(W));
+
+    uint64_t x = (static_cast<uint64_t>(e) << 32 | dest) ^ (bits * 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+template <class W>
+inline void BasicCsrGraph<W>::clear() {
+    offsets.clear();
+    dest.clear();
+    weight.clear();
+    storedFingerprint = 0;
+}
+
+/**
+ * Read-only view of CSR arrays owned elsewhere (e.g. the pages of a mapped GraphSnapshot), with the same interface as
+ * CsrGraph, so the searches templated on the graph type run on it without copying the arrays.
+ */
+struct CsrView {
+    const uint32_t* offsets = nullptr;
+    const uint32_t* dest = nullptr;
+    const float* weight = nullptr;
+    uint32_t vertices = 0;
+    uint32_t edges = 0;
+
+    uint32_t numVertices() const;
+    uint32_t numEdges() const;
+
+    uint32_t edgesBegin(uint32_t v) const;
+    uint32_t edgesEnd(uint32_t v) const;
+};
+
+inline uint32_t CsrView::numVertices() const {
+    return vertices;
+}
+
+inline uint32_t CsrView::numEdges() const {
+    return edges;
+}
+
+inline uint32_t CsrView::edgesBegin(uint32_t v) const {
+    return offsets[v];
+}
+
+inline uint32_t CsrView::edgesEnd(uint32_t v) const {
+    return offsets[v + 1];
+}
+
+#endif // CSR_GRAPH_H
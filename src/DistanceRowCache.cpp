@@ -0,0 +1,182 @@
+#include "DistanceRowCache.h"
+#include "SearchWorkspace.h"
+#include "ShortestPathRepair.h"
+
+#include <algorithm>
+#include <limits>
+
+static const float INF = std::numeric_limits<float>::max();
+
+constexpr size_t DistanceRowCache::NO_ROW;
+
+/**
+ * @brief Copies the distances and predecessors of the vertices reached by the last search of a workspace into a row.
+ */
+static void copyRow(const SearchWorkspace& workspace, float* dist, uint32_t* pred) {
+    for (uint32_t v : workspace.reachedVertices) {
+        dist[v] = workspace.getDist(v);
+        pred[v] = workspace.getPred(v);
+    }
+}
+
+/**
+ * @brief Computes the rows of every source, replacing the previous contents of the cache. The forward rows come from
+ * Dijkstra searches on the graph, and the reverse rows from searches on its reverse, whose predecessors are the
+ * successors in the original graph.
+ * @param graph     CSR graph
+ * @param reverse   reverse of the CSR graph
+ * @param sources   indices of the sources, one per row
+ * @param pool      if not null, the rows are computed in parallel by the workers of the pool
+ */
+void DistanceRowCache::build(const CsrGraph& graph, const CsrGraph& reverse, const std::vector<uint32_t>& sources,
+                             ThreadPool* pool) {
+    this->sources = sources;
+    numVertices = graph.numVertices();
+    numEdges = graph.numEdges();
+    fingerprint = graph.fingerprint();
+
+    rowOfVertex.assign(numVertices, NO_ROW);
+    for (size_t row = 0; row < sources.size(); ++row) {
+        rowOfVertex[sources[row]] = row;
+    }
+
+    forwardDistances = FlatMatrix<float>(sources.size(), numVertices, INF);
+    forwardPred = FlatMatrix<uint32_t>(sources.size(), numVertices, NO_VERTEX);
+    reverseDistances = FlatMatrix<float>(sources.size(), numVertices, INF);
+    reverseSucc = FlatMatrix<uint32_t>(sources.size(), numVertices, NO_VERTEX);
+
+    auto buildRow = [&](SearchWorkspace& workspace, size_t row) {
+        dijkstraOverCsr(graph, sources[row], workspace);
+        copyRow(workspace, forwardDistances[row], forwardPred[row]);
+
+        dijkstraOverCsr(reverse, sources[row], workspace);
+        copyRow(workspace, reverseDistances[row], reverseSucc[row]);
+    };
+
+    if (pool != nullptr) {
+        std::vector<SearchWorkspace> workspaces(pool->size());
+        pool->parallelFor(sources.size(), [&](unsigned worker, size_t row) {
+            buildRow(workspaces[worker], row);
+        });
+    }
+    else {
+        SearchWorkspace workspace;
+        for (size_t row = 0; row < sources.size(); ++row) {
+            buildRow(workspace, row);
+        }
+    }
+}
+
+/**
+ * @brief Repairs every row after the edges from one vertex to another were updated or removed (see
+ * repairShortestPathTree), so the cache keeps matching the graph. Must be called after each change.
+ * @param graph     CSR graph, already with the changed edges
+ * @param reverse   reverse of the CSR graph, also already changed
+ * @param from      index of the vertex the changed edges leave
+ * @param to        index of the vertex the changed edges enter
+ * @param pool      if not null, the rows are repaired in parallel by the workers of the pool
+ */
+void DistanceRowCache::repair(const CsrGraph& graph, const CsrGraph& reverse, uint32_t from, uint32_t to,
+                              ThreadPool* pool) {
+    numEdges = graph.numEdges();
+    fingerprint = graph.fingerprint();
+
+    // In the reverse graph, the changed edges go from the vertex they used to enter
+    auto repairRow = [&](SearchWorkspace& workspace, size_t row) {
+        repairShortestPathTree(graph, reverse, sources[row], from, to, forwardDistances[row], forwardPred[row],
+                               NO_VERTEX, workspace);
+        repairShortestPathTree(reverse, graph, sources[row], to, from, reverseDistances[row], reverseSucc[row],
+                               NO_VERTEX, workspace);
+    };
+
+    if (pool != nullptr) {
+        std::vector<SearchWorkspace> workspaces(pool->size());
+        pool->parallelFor(sources.size(), [&](unsigned worker, size_t row) {
+            repairRow(workspaces[worker], row);
+        });
+    }
+    else {
+        SearchWorkspace workspace;
+        for (size_t row = 0; row < sources.size(); ++row) {
+            repairRow(workspace, row);
+        }
+    }
+}
+
+/**
+ * @brief Checks if the rows of the cache were computed on the given graph (i.e. one with the same size and fingerprint).
+ * An edge updated without calling repair leaves the size unchanged, but not the fingerprint, which the graph keeps up
+ * to date, so the check takes constant time.
+ */
+bool DistanceRowCache::matches(const CsrGraph& graph) const {
+    return numVertices == graph.numVertices() && numEdges == graph.numEdges() && fingerprint == graph.fingerprint();
+}
+
+/**
+ * @brief Checks if the cache has the rows of the given sources, in the same order, computed on the given graph.
+ */
+bool DistanceRowCache::matches(const CsrGraph& graph, const std::vector<uint32_t>& sources) const {
+    return matches(graph) && this->sources == sources;
+}
+
+size_t DistanceRowCache::numRows() const {
+    return sources.size();
+}
+
+uint32_t DistanceRowCache::getSource(size_t row) const {
+    return sources[row];
+}
+
+/**
+ * @return  row of the given source (the last one, if it is repeated), or NO_ROW if the vertex is not a source
+ */
+size_t DistanceRowCache::findRow(uint32_t source) const {
+    return source < rowOfVertex.size() ? rowOfVertex[source] : NO_ROW;
+}
+
+/**
+ * @return  distance from the source of a row to a vertex (MAX_FLOAT if unreachable)
+ */
+float DistanceRowCache::forwardDist(size_t row, uint32_t v) const {
+    return forwardDistances[row][v];
+}
+
+/**
+ * @return  distance from a vertex to the source of a row (MAX_FLOAT if unreachable)
+ */
+float DistanceRowCache::reverseDist(size_t row, uint32_t v) const {
+    return reverseDistances[row][v];
+}
+
+/**
+ * @brief Rebuilds the shortest path from the source of a row to a vertex, walking back through the predecessors.
+ * @param path      filled with the indices of the vertices of the path, from the source to the target
+ * @return          false if the target is unreachable, in which case the path is left empty
+ */
+bool DistanceRowCache::forwardPath(size_t row, uint32_t target, std::vector<uint32_t>& path) const {
+    path.clear();
+    if (forwardDistances[row][target] == INF)
+        return false;
+
+    for (uint32_t v = target; v != NO_VERTEX; v = forwardPred[row][v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+/**
+ * @brief Rebuilds the shortest path from a vertex to the source of a row, walking forward through the successors.
+ * @param path      filled with the indices of the vertices of the path, from the given vertex to the source
+ * @return          false if the source is unreachable from the vertex, in which case the path is left empty
+ */
+bool DistanceRowCache::reversePath(size_t row, uint32_t from, std::vector<uint32_t>& path) const {
+    path.clear();
+    if (reverseDistances[row][from] == INF)
+        return false;
+
+    for (uint32_t v = from; v != NO_VERTEX; v = reverseSucc[row][v]) {
+        path.push_back(v);
+    }
+    return true;
+}
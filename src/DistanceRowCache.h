@@ -0,0 +1,62 @@
+#ifndef DISTANCE_ROW_CACHE_H
+#define DISTANCE_ROW_CACHE_H
+
+#include "CsrGraph.h"
+#include "FlatMatrix.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Shortest path trees of a fixed set of sources (typically the points of interest of a map), kept across trip requests
+ * on the same map. For each source there is a forward row, with the distance from the source to every vertex and the
+ * predecessor of every vertex in the shortest path from the source, and a reverse row, with the distance from every
+ * vertex to the source and the successor of every vertex in its shortest path to the source.
+ *
+ * Every entry of the adjacency matrix of a trip among the sources, whatever its start and finish vertices, is then
+ * read from the rows, and every leg of the trip is unpacked from them, without any search. When edges of the graph
+ * change, the rows are repaired instead of being built again.
+ */
+class DistanceRowCache {
+public:
+    // Returned by findRow for vertices which are not sources of the cache
+    static constexpr size_t NO_ROW = SIZE_MAX;
+
+    DistanceRowCache() = default;
+
+    void build(const CsrGraph& graph, const CsrGraph& reverse, const std::vector<uint32_t>& sources,
+               ThreadPool* pool = nullptr);
+    bool matches(const CsrGraph& graph) const;
+    bool matches(const CsrGraph& graph, const std::vector<uint32_t>& sources) const;
+    void repair(const CsrGraph& graph, const CsrGraph& reverse, uint32_t from, uint32_t to, ThreadPool* pool = nullptr);
+
+    size_t numRows() const;
+    uint32_t getSource(size_t row) const;
+    size_t findRow(uint32_t source) const;
+
+    float forwardDist(size_t row, uint32_t v) const;
+    float reverseDist(size_t row, uint32_t v) const;
+    bool forwardPath(size_t row, uint32_t target, std::vector<uint32_t>& path) const;
+    bool reversePath(size_t row, uint32_t from, std::vector<uint32_t>& path) const;
+private:
+    std::vector<uint32_t> sources;
+    // Row of each vertex which is a source (NO_ROW for the other vertices)
+    std::vector<size_t> rowOfVertex;
+
+    // Row r of each matrix belongs to sources[r], and column v to vertex v
+    FlatMatrix<float> forwardDistances;
+    FlatMatrix<uint32_t> forwardPred;
+    FlatMatrix<float> reverseDistances;
+    FlatMatrix<uint32_t> reverseSucc;
+
+    // Size and fingerprint of the graph the rows were computed on, used to detect stale caches
+    uint32_t numVertices = 0;
+    uint32_t numEdges = 0;
+    uint64_t fingerprint = 0;
+
+    // Snapshots store the rows and restore them without searching
+    friend class GraphSnapshot;
+};
+
+#endif // DISTANCE_ROW_CACHE_H
@@ -0,0 +1,115 @@
+#ifndef FLAT_MATRIX_H
+#define FLAT_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/**
+ * Allocator returning memory aligned to a given number of bytes, so that SIMD loads of whole rows are aligned.
+ */
+template <class E, size_t ALIGNMENT>
+struct AlignedAllocator {
+    using value_type = E;
+
+    template <class U>
+    struct rebind {
+        using other = AlignedAllocator<U, ALIGNMENT>;
+    };
+
+    AlignedAllocator() = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, ALIGNMENT>&) {}
+
+    E* allocate(size_t n) {
+        // Over-allocate and keep the pointer returned by operator new just before the aligned block
+        char* raw = static_cast<char*>(::operator new(n * sizeof(E) + ALIGNMENT + sizeof(void*)));
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<E*>(aligned);
+    }
+
+    void deallocate(E* p, size_t) {
+        ::operator delete(reinterpret_cast<void**>(p)[-1]);
+    }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, ALIGNMENT>&) const { return true; }
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, ALIGNMENT>&) const { return false; }
+};
+
+/**
+ * Dense matrix stored row by row in a single contiguous buffer. Every row starts on a cache line boundary: the
+ * distance between the start of consecutive rows (the stride) is the number of columns rounded up to a whole
+ * number of cache lines.
+ */
+template <class E>
+class FlatMatrix {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    FlatMatrix() = default;
+    FlatMatrix(size_t rows, size_t cols, E value);
+
+    size_t numRows() const;
+    size_t numCols() const;
+    size_t getStride() const;
+
+    E* data();
+    const E* data() const;
+
+    E* operator[](size_t row);
+    const E* operator[](size_t row) const;
+private:
+    size_t rows = 0, cols = 0, stride = 0;
+    std::vector<E, AlignedAllocator<E, ALIGNMENT>> elements;
+};
+
+template <class E>
+constexpr size_t FlatMatrix<E>::ALIGNMENT;
+
+template <class E>
+FlatMatrix<E>::FlatMatrix(size_t rows, size_t cols, E value) : rows(rows), cols(cols) {
+    const size_t elementsPerLine = ALIGNMENT / sizeof(E);
+    stride = (cols + elementsPerLine - 1) / elementsPerLine * elementsPerLine;
+    elements.assign(rows * stride, value);
+}
+
+template <class E>
+size_t FlatMatrix<E>::numRows() const {
+    return rows;
+}
+
+template <class E>
+size_t FlatMatrix<E>::numCols() const {
+    return cols;
+}
+
+template <class E>
+size_t FlatMatrix<E>::getStride() const {
+    return stride;
+}
+
+template <class E>
+E* FlatMatrix<E>::data() {
+    return elements.data();
+}
+
+template <class E>
+const E* FlatMatrix<E>::data() const {
+    return elements.data();
+}
+
+template <class E>
+E* FlatMatrix<E>::operator[](size_t row) {
+    return elements.data() + row * stride;
+}
+
+template <class E>
+const E* FlatMatrix<E>::operator[](size_t row) const {
+    return elements.data() + row * stride;
+}
+
+#endif // FLAT_MATRIX_H
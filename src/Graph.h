@@ -1,343 +1,946 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#include "MutablePriorityQueue.h"
+#include "CsrGraph.h"
+#include "SearchWorkspace.h"
+#include "pointToPoint.h"
+#include "ThreadPool.h"
+#include "FlatMatrix.h"
+#include "floydWarshall.h"
+#include "ContractionHierarchy.h"
+#include "manyToMany.h"
+#include "MonotonePriorityQueues.h"
+#include "HeapPolicies.h"
+#include "PredecessorTrees.h"
+#include "DistanceRowCache.h"
+#include "ShortestPathRepair.h"
+#include "Landmarks.h"
+#include "Arena.h"
+#include "WeightTraits.h"
 
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <string>
 #include <limits>
+#include <unordered_map>
+#include <algorithm>
+#include <new>
+#include <utility>
 
-template<class T> class Edge;
-template<class T> class Graph;
+template<class T, class W = float> class Edge;
+template<class T, class W = float> class Graph;
 
 constexpr float MAX_FLOAT = std::numeric_limits<float>::max();
 
-template<class T>
+// Adjacency list of a vertex, placed in the arena of its graph
+template<class T, class W = float>
+using EdgeList = std::vector<Edge<T, W>, ArenaAllocator<Edge<T, W>>>;
+
+/**
+ * Vertex of a graph whose edges have weights of type W (see WeightTraits).
+ */
+template<class T, class W = float>
 class Vertex {
 public:
     const T& getInfo() const;
-    float getDist() const;
-    Vertex<T>* getPath() const;
-    const std::vector<Edge<T>>& getAdj() const;
-
-    void addEdge(Vertex<T>* dest, float weight);
-
-    bool isPOI(const std::vector<Vertex<T>*>& pointsOfInterest);
+    uint32_t getIndex() const;
+    W getDist() const;
+    Vertex<T, W>* getPath() const;
+    const EdgeList<T, W>& getAdj() const;
 
-    // Required by MutablePriorityQueue
-    bool operator<(const Vertex<T>& vertex) const;
+    void addEdge(Vertex<T, W>* dest, W weight);
 
-    friend class Graph<T>;
-
-    // Required by MutablePriorityQueue
-    int queueIndex = 0;
+    friend class Graph<T, W>;
 private:
-    explicit Vertex(T info);
+    Vertex(T info, Arena* arena);
 
     T info;
-    std::vector<Edge<T>> adj;
+    EdgeList<T, W> adj;
+
+    // Dense index of the vertex in the graph's vertex set, used by the CSR representation
+    uint32_t index = 0;
 
     // Fields used in Dijkstra's Shortest Path
-    float dist = 0;
-    Vertex<T>* path = nullptr;
+    W dist = WeightTraits<W>::infinity();
+    Vertex<T, W>* path = nullptr;
 };
 
-template<class T>
-Vertex<T>::Vertex(T info) : info(info) {}
+template<class T, class W>
+Vertex<T, W>::Vertex(T info, Arena* arena) : info(info), adj(ArenaAllocator<Edge<T, W>>(arena)) {}
 
-template<class T>
-const T& Vertex<T>::getInfo() const {
+template<class T, class W>
+const T& Vertex<T, W>::getInfo() const {
     return info;
 }
 
-template<class T>
-float Vertex<T>::getDist() const {
+template<class T, class W>
+uint32_t Vertex<T, W>::getIndex() const {
+    return index;
+}
+
+template<class T, class W>
+W Vertex<T, W>::getDist() const {
     return dist;
 }
 
-template<class T>
-Vertex<T>* Vertex<T>::getPath() const {
+template<class T, class W>
+Vertex<T, W>* Vertex<T, W>::getPath() const {
     return path;
 }
 
-template<class T>
-const vector<Edge<T>> &Vertex<T>::getAdj() const {
+template<class T, class W>
+const EdgeList<T, W> &Vertex<T, W>::getAdj() const {
     return adj;
 }
 
 
-template<class T>
-void Vertex<T>::addEdge(Vertex<T>* dest, float weight) {
-    adj.push_back(Edge<T>(dest, weight));
+template<class T, class W>
+void Vertex<T, W>::addEdge(Vertex<T, W>* dest, W weight) {
+    adj.push_back(Edge<T, W>(dest, weight));
 }
 
 
-template <class T>
-bool Vertex<T>::isPOI(const std::vector<Vertex<T>*>& pointsOfInterest) {
-    for (Vertex<T> * u : pointsOfInterest) {
-        if (this->getInfo() == u->getInfo()) {
-            return true;
-        }
+/**
+ * @brief Builds the table of the dense indices of the points of interest (entry i is the index of the i-th point of
+ * interest), used to gather their rows and columns of matrices indexed by vertex and to look them up in paths.
+ */
+template <class T, class W>
+std::vector<uint32_t> pointOfInterestIndices(const std::vector<Vertex<T, W>*>& pointsOfInterest) {
+    std::vector<uint32_t> indices;
+    indices.reserve(pointsOfInterest.size());
+    for (const Vertex<T, W>* POI : pointsOfInterest) {
+        indices.push_back(POI->getIndex());
     }
-    return false;
+    return indices;
 }
 
 
-template<class T>
-bool Vertex<T>::operator<(const Vertex<T>& vertex) const {
-    return dist < vertex.dist;
-}
-
 
-
-template<class T>
+template<class T, class W>
 class Edge {
 public:
-    Edge(Vertex<T>* dest, float weight);
+    Edge(Vertex<T, W>* dest, W weight);
 
-    const Vertex<T>* getDest() const;
+    const Vertex<T, W>* getDest() const;
+    W getWeight() const;
 
-    friend class Vertex<T>;
-    friend class Graph<T>;
+    friend class Vertex<T, W>;
+    friend class Graph<T, W>;
 private:
-    Vertex<T>* dest;
-    float weight;
+    Vertex<T, W>* dest;
+    W weight;
 };
 
-template<class T>
-Edge<T>::Edge(Vertex<T>* dest, float weight) : dest(dest), weight(weight) {}
+template<class T, class W>
+Edge<T, W>::Edge(Vertex<T, W>* dest, W weight) : dest(dest), weight(weight) {}
+
+template<class T, class W>
+const Vertex<T, W>* Edge<T, W>::getDest() const { return dest; }
 
-template<class T>
-const Vertex<T>* Edge<T>::getDest() const { return dest; }
+template<class T, class W>
+W Edge<T, W>::getWeight() const { return weight; }
 
 
 /**
- * Class for representing a Graph with weighted directed edges.
+ * Class for representing a Graph with weighted directed edges, with weights of type W (see WeightTraits). The members
+ * which take a contraction hierarchy, landmarks, a row cache or the Floyd-Warshall matrices only compile for float
+ * graphs, which those are built on.
  */
-template<class T>
+template<class T, class W>
 class Graph {
 public:
+    Graph() = default;
+    Graph(const Graph&) = delete;
+    Graph& operator=(const Graph&) = delete;
     ~Graph();
 
-    std::vector<Vertex<T>*> getVertexSet() const;
+    std::vector<Vertex<T, W>*> getVertexSet() const;
+    size_t getNumVertices() const;
+    Vertex<T, W>* getVertex(uint32_t index) const;
 
-    Vertex<T>* findVertex(const T& info);
+    Vertex<T, W>* findVertex(const T& info) const;
+    void reserveVertices(size_t numVertices);
+    void reserveEdges(const std::vector<size_t>& outDegrees);
     bool addVertex(const T& info);
-    bool addEdge(const T& source, const T& dest, float weight);
-
+    bool addEdge(const T& source, const T& dest, W weight);
+    void addEdge(Vertex<T, W>* source, Vertex<T, W>* dest, W weight);
+    bool updateEdgeWeight(const T& source, const T& dest, W weight);
+    bool updateEdgeWeight(Vertex<T, W>* source, Vertex<T, W>* dest, W weight);
+    bool removeEdge(const T& source, const T& dest);
+    bool removeEdge(Vertex<T, W>* source, Vertex<T, W>* dest);
+
+    void freeze();
+    const BasicCsrGraph<W>& getCsr() const;
+    const BasicCsrGraph<W>& getReverseCsr() const;
+
+    void dijkstra(const Vertex<T, W>* source, BasicSearchWorkspace<W>& workspace) const;
+    void dijkstra(const Vertex<T, W>* source, const std::vector<uint32_t>& targets, W cutoff,
+                  BasicSearchWorkspace<W>& workspace) const;
+    template<class Queue>
+    void dijkstra(const Vertex<T, W>* source, BasicSearchWorkspace<W>& workspace, Queue& queue) const;
     void dijkstraShortestPath(const T& source);
-    void floydWarshallShortestPath(std::vector<std::vector<float>> & weight, std::vector<std::vector<int>> & path);
-    std::vector<std::vector<float>> initializeFloydWarshallWeightVector();
-    std::vector<std::vector< int  >> initializeFloydWarshallPathVector();
-
-    std::vector<std::vector<float>> generateAdjacencyMatrixWithFloydWarshall(const std::vector<Vertex<T>*>& pointsOfInterest, Vertex<T> * start, Vertex<T> * finish);
-
-    std::vector<std::vector<float>> generateAdjacencyMatrixWithDijkstra(
-            const std::vector<Vertex<T>*>& pointsOfInterest, Vertex<T> * start, Vertex<T> * finish);
+    template<class Queue>
+    void dijkstraShortestPath(const T& source, Queue& queue);
+
+    template<class Heuristic>
+    W astar(const Vertex<T, W>* source, const Vertex<T, W>* target, const Heuristic& heuristic, W cutoff,
+            BasicSearchWorkspace<W>& workspace, std::vector<Vertex<T, W>*>* path = nullptr) const;
+    W bidirectionalDijkstra(const Vertex<T, W>* source, const Vertex<T, W>* target, W cutoff,
+                            BasicSearchWorkspace<W>& forward, BasicSearchWorkspace<W>& backward,
+                            std::vector<Vertex<T, W>*>* path = nullptr) const;
+    W contractionHierarchyQuery(const ContractionHierarchy& hierarchy, const Vertex<T, W>* source,
+                                const Vertex<T, W>* target, BasicSearchWorkspace<W>& forward,
+                                BasicSearchWorkspace<W>& backward, std::vector<Vertex<T, W>*>* path = nullptr) const;
+    W altQuery(const Landmarks& landmarks, const Vertex<T, W>* source, const Vertex<T, W>* target, W cutoff,
+               BasicSearchWorkspace<W>& workspace, std::vector<Vertex<T, W>*>* path = nullptr) const;
+    void floydWarshallShortestPath(FlatMatrix<W> & weight, FlatMatrix<int32_t> & path, ThreadPool* pool = nullptr);
+    FlatMatrix<W> initializeFloydWarshallWeightMatrix() const;
+    FlatMatrix<int32_t> initializeFloydWarshallPathMatrix() const;
+    bool floydWarshallPath(const FlatMatrix<int32_t>& path, const Vertex<T, W>* source,
+                           const Vertex<T, W>* target, std::vector<Vertex<T, W>*>& output) const;
+    void repairFloydWarshall(FlatMatrix<W> & weight, FlatMatrix<int32_t> & path, const Vertex<T, W>* source,
+                             const Vertex<T, W>* dest, ThreadPool* pool = nullptr);
+
+    template<class M = W>
+    std::vector<std::vector<M>> generateAdjacencyMatrixWithFloydWarshall(const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish, ThreadPool* pool = nullptr, FlatMatrix<int32_t> * path = nullptr);
+    template<class M = W>
+    std::vector<std::vector<M>> generateAdjacencyMatrixFromFloydWarshall(
+            const std::vector<Vertex<T, W>*>& pointsOfInterest, const Vertex<T, W> * start, const Vertex<T, W> * finish,
+            const FlatMatrix<W> & weight) const;
+
+    template<class M = W>
+    std::vector<std::vector<M>> generateAdjacencyMatrixWithDijkstra(
+            const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish,
+            W cutoff = WeightTraits<W>::infinity(), PredecessorTrees* trees = nullptr);
+    template<class M = W>
+    std::vector<std::vector<M>> generateAdjacencyMatrixWithDijkstra(
+            const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish,
+            ThreadPool& pool, W cutoff = WeightTraits<W>::infinity(), PredecessorTrees* trees = nullptr);
+    template<class M = W>
+    std::vector<std::vector<M>> generateAdjacencyMatrixWithContractionHierarchy(
+            const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish,
+            const ContractionHierarchy& hierarchy);
+    template<class M = W>
+    std::vector<std::vector<M>> generateAdjacencyMatrixWithManyToMany(
+            const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish,
+            W cutoff = WeightTraits<W>::infinity(), const ContractionHierarchy* hierarchy = nullptr);
+    template<class M = W>
+    std::vector<std::vector<M>> generateAdjacencyMatrixFromCache(
+            const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish,
+            const DistanceRowCache& cache);
+    std::vector<size_t> feasiblePointsOfInterest(const std::vector<Vertex<T, W>*>& pointsOfInterest,
+            const Vertex<T, W>* start, const Vertex<T, W>* finish, W budget,
+            const DistanceRowCache* cache = nullptr, const Landmarks* landmarks = nullptr) const;
 private:
-    std::vector<Vertex<T>*> vertexSet;
+    // Holds the vertices and their adjacency lists, which are freed all at once with the graph
+    Arena arena;
+    std::vector<Vertex<T, W>*> vertexSet;
     int findVertexIdx(const T& in) const;
+
+    // Maps the information of each vertex to its index in vertexSet
+    std::unordered_map<T, uint32_t> vertexIndex;
+
+    // Frozen CSR copies of the adjacency lists (and of the reversed ones, used by backward searches), rebuilt by
+    // freeze() after the graph is modified
+    BasicCsrGraph<W> csr;
+    BasicCsrGraph<W> reverseCsr;
+    bool csrValid = false;
+
+    // Workspace reused by dijkstraShortestPath, and the indices of the vertices whose dist and path fields it set (the
+    // fields of every other vertex are infinite and nullptr)
+    BasicSearchWorkspace<W> pathWorkspace;
+    std::vector<uint32_t> pathReachedVertices;
+
+    std::vector<uint32_t> adjacencyMatrixTargets(const std::vector<Vertex<T, W>*>& pointsOfInterest,
+            const Vertex<T, W>* finish) const;
+    template<class M>
+    void fillAdjacencyMatrixRow(const std::vector<Vertex<T, W>*>& pointsOfInterest, const Vertex<T, W>* start,
+            const Vertex<T, W>* finish, const std::vector<uint32_t>& targets, W cutoff, size_t row,
+            BasicSearchWorkspace<W>& workspace, std::vector<M>& output, PredecessorTrees* trees) const;
 };
 
-template<class T>
-Graph<T>::~Graph() {
-    for (Vertex<T>* v : vertexSet) {
-        delete v;
+template<class T, class W>
+Graph<T, W>::~Graph() {
+    for (Vertex<T, W>* v : vertexSet) {
+        v->~Vertex();
     }
 }
 
-template<class T>
-std::vector<Vertex<T>*> Graph<T>::getVertexSet() const {
+template<class T, class W>
+std::vector<Vertex<T, W>*> Graph<T, W>::getVertexSet() const {
     return vertexSet;
 }
 
-template<class T>
-Vertex<T>* Graph<T>::findVertex(const T& info) {
-    for (auto v : vertexSet) {
-        if (v->info == info) {
-            return v;
-        }
-    }
-    return nullptr;
+template<class T, class W>
+size_t Graph<T, W>::getNumVertices() const {
+    return vertexSet.size();
+}
+
+template<class T, class W>
+Vertex<T, W>* Graph<T, W>::getVertex(uint32_t index) const {
+    return vertexSet[index];
+}
+
+template<class T, class W>
+Vertex<T, W>* Graph<T, W>::findVertex(const T& info) const {
+    int idx = findVertexIdx(info);
+    return idx == -1 ? nullptr : vertexSet[idx];
 }
 
 /**
  * @brief Finds the index of the vertex with a given content.
  */
-template <class T>
-int Graph<T>::findVertexIdx(const T &in) const {
-    for (unsigned i = 0; i < vertexSet.size(); i++)
-        if (vertexSet[i]->info == in)
-            return i;
-    return -1;
+template <class T, class W>
+int Graph<T, W>::findVertexIdx(const T &in) const {
+    auto it = vertexIndex.find(in);
+    return it == vertexIndex.end() ? -1 : it->second;
+}
+
+/**
+ * @brief Prepares the graph for a known number of new vertices (e.g. from the header of a map file), so they are
+ * placed contiguously in a single block and their lookup tables are not rehashed or regrown while they are added.
+ */
+template<class T, class W>
+void Graph<T, W>::reserveVertices(size_t numVertices) {
+    vertexSet.reserve(vertexSet.size() + numVertices);
+    vertexIndex.reserve(vertexIndex.size() + numVertices);
+    arena.reserve(numVertices * sizeof(Vertex<T, W>));
+}
+
+/**
+ * @brief Prepares the adjacency lists for a known number of new edges, so every list has room for its new edges
+ * without growing, and all of them are placed contiguously in a single block.
+ * @param outDegrees    number of edges that will be added from each vertex, indexed by vertex index
+ */
+template<class T, class W>
+void Graph<T, W>::reserveEdges(const std::vector<size_t>& outDegrees) {
+    size_t numEdges = 0;
+    for (size_t v = 0; v < outDegrees.size(); ++v) {
+        numEdges += vertexSet[v]->adj.size() + outDegrees[v];
+    }
+    arena.reserve(numEdges * sizeof(Edge<T, W>));
+
+    for (size_t v = 0; v < outDegrees.size(); ++v) {
+        vertexSet[v]->adj.reserve(vertexSet[v]->adj.size() + outDegrees[v]);
+    }
 }
 
-template<class T>
-bool Graph<T>::addVertex(const T& info) {
-    if (findVertex(info) != nullptr)
+template<class T, class W>
+bool Graph<T, W>::addVertex(const T& info) {
+    if (!vertexIndex.emplace(info, vertexSet.size()).second)
         return false;
 
-    vertexSet.push_back(new Vertex<T>(info));
+    Vertex<T, W>* vertex = new (arena.allocate(sizeof(Vertex<T, W>), alignof(Vertex<T, W>))) Vertex<T, W>(info, &arena);
+    vertex->index = vertexSet.size();
+    vertexSet.push_back(vertex);
+    csrValid = false;
     return true;
 }
 
-template<class T>
-bool Graph<T>::addEdge(const T& source, const T& dest, float weight) {
-    Vertex<T>* sourcePtr = findVertex(source);
-    Vertex<T>* destPtr = findVertex(dest);
+template<class T, class W>
+bool Graph<T, W>::addEdge(const T& source, const T& dest, W weight) {
+    Vertex<T, W>* sourcePtr = findVertex(source);
+    Vertex<T, W>* destPtr = findVertex(dest);
 
     if (sourcePtr == nullptr || destPtr == nullptr)
         return false;
 
-    sourcePtr->addEdge(destPtr, weight);
+    addEdge(sourcePtr, destPtr, weight);
     return true;
 }
 
 /**
- * @brief Calculates the shortest path from a given vertex to all others using
- * Dijkstra's algorithm.
- * @param source    source vertex information
+ * @brief Adds an edge between two vertices of the graph, skipping the lookup of their information.
  */
-template<class T>
-void Graph<T>::dijkstraShortestPath(const T& source) {
-    MutablePriorityQueue<Vertex<T>> queue;
+template<class T, class W>
+void Graph<T, W>::addEdge(Vertex<T, W>* source, Vertex<T, W>* dest, W weight) {
+    source->addEdge(dest, weight);
+    csrValid = false;
+}
+
+template<class T, class W>
+bool Graph<T, W>::updateEdgeWeight(const T& source, const T& dest, W weight) {
+    Vertex<T, W>* sourcePtr = findVertex(source);
+    Vertex<T, W>* destPtr = findVertex(dest);
+
+    if (sourcePtr == nullptr || destPtr == nullptr)
+        return false;
 
-    for (Vertex<T>* vertex : vertexSet) {
-        vertex->path = NULL;
+    return updateEdgeWeight(sourcePtr, destPtr, weight);
+}
 
-        if (vertex->info == source) {
-            vertex->dist = 0;
-            vertex->queueIndex = 0;
-            queue.insert(vertex);
+/**
+ * @brief Changes the weight of the edges from one vertex to another (e.g. to model congestion). A frozen graph stays
+ * frozen, as its CSR copies are patched in place, so the shortest paths derived from it can then be repaired with
+ * DistanceRowCache::repair or repairFloydWarshall instead of being computed again. Contraction hierarchies built
+ * before the change no longer match the graph.
+ * @return  false if there is no edge from the source to the destination
+ */
+template<class T, class W>
+bool Graph<T, W>::updateEdgeWeight(Vertex<T, W>* source, Vertex<T, W>* dest, W weight) {
+    bool found = false;
+    for (Edge<T, W>& edge : source->adj) {
+        if (edge.dest == dest) {
+            edge.weight = weight;
+            found = true;
         }
-        else {
-            vertex->dist = MAX_FLOAT;
+    }
+
+    if (found && csrValid) {
+        for (uint32_t e = csr.edgesBegin(source->index); e < csr.edgesEnd(source->index); ++e) {
+            if (csr.dest[e] == dest->index) {
+                csr.setWeight(e, weight);
+            }
+        }
+        for (uint32_t e = reverseCsr.edgesBegin(dest->index); e < reverseCsr.edgesEnd(dest->index); ++e) {
+            if (reverseCsr.dest[e] == source->index) {
+                reverseCsr.setWeight(e, weight);
+            }
         }
     }
+    return found;
+}
 
-    while (!queue.empty()) {
-        Vertex<T>* vertex = queue.extractMin();
+template<class T, class W>
+bool Graph<T, W>::removeEdge(const T& source, const T& dest) {
+    Vertex<T, W>* sourcePtr = findVertex(source);
+    Vertex<T, W>* destPtr = findVertex(dest);
 
-        for (const Edge<T>& edge : vertex->adj) {
-            bool notInQueue = edge.dest->dist == MAX_FLOAT;
+    if (sourcePtr == nullptr || destPtr == nullptr)
+        return false;
 
-            if (edge.dest->dist > vertex->dist + edge.weight) {
-                edge.dest->dist = vertex->dist + edge.weight;
-                edge.dest->path = vertex;
+    return removeEdge(sourcePtr, destPtr);
+}
+
+/**
+ * @brief Removes the edges from one vertex to another (e.g. to model a road closure). The CSR copies are rebuilt by
+ * the next call to freeze(), after which the shortest paths derived from the graph can be repaired like after
+ * updateEdgeWeight.
+ * @return  false if there is no edge from the source to the destination
+ */
+template<class T, class W>
+bool Graph<T, W>::removeEdge(Vertex<T, W>* source, Vertex<T, W>* dest) {
+    auto removed = std::remove_if(source->adj.begin(), source->adj.end(), [dest](const Edge<T, W>& edge) {
+        return edge.dest == dest;
+    });
+    if (removed == source->adj.end())
+        return false;
+
+    source->adj.erase(removed, source->adj.end());
+    csrValid = false;
+    return true;
+}
+
+/**
+ * @brief Builds the CSR representation of the graph, if the graph was modified since it was last built. The non-const
+ * shortest path algorithms call this themselves, but it must be called explicitly before using getCsr() or the const
+ * queries, which never modify the graph and can therefore run concurrently on a frozen graph.
+ */
+template<class T, class W>
+void Graph<T, W>::freeze() {
+    if (csrValid)
+        return;
+
+    csr.clear();
+    csr.offsets.reserve(vertexSet.size() + 1);
+    csr.offsets.push_back(0);
+    for (Vertex<T, W>* vertex : vertexSet) {
+        csr.offsets.push_back(csr.offsets.back() + vertex->adj.size());
+    }
+
+    csr.dest.reserve(csr.offsets.back());
+    csr.weight.reserve(csr.offsets.back());
+    for (Vertex<T, W>* vertex : vertexSet) {
+        for (const Edge<T, W>& edge : vertex->adj) {
+            csr.dest.push_back(edge.dest->index);
+            csr.weight.push_back(edge.weight);
+        }
+    }
 
-                if (notInQueue) {
-                    edge.dest->queueIndex = edge.dest->dist;
-                    queue.insert(edge.dest);
-                }
-                else {
-                    queue.decreaseKey(edge.dest);
-                }
+    // The reverse graph is built with a counting sort of the edges by destination
+    reverseCsr.clear();
+    reverseCsr.offsets.assign(vertexSet.size() + 1, 0);
+    for (uint32_t dest : csr.dest) {
+        ++reverseCsr.offsets[dest + 1];
+    }
+    for (size_t v = 0; v < vertexSet.size(); ++v) {
+        reverseCsr.offsets[v + 1] += reverseCsr.offsets[v];
+    }
+
+    reverseCsr.dest.resize(csr.numEdges());
+    reverseCsr.weight.resize(csr.numEdges());
+    std::vector<uint32_t> next(reverseCsr.offsets.begin(), reverseCsr.offsets.end() - 1);
+    for (uint32_t v = 0; v < csr.numVertices(); ++v) {
+        for (uint32_t e = csr.edgesBegin(v); e < csr.edgesEnd(v); ++e) {
+            uint32_t position = next[csr.dest[e]]++;
+            reverseCsr.dest[position] = v;
+            reverseCsr.weight[position] = csr.weight[e];
+        }
+    }
+
+    // Data derived from the graph compares these on every check, so they are computed once here
+    csr.updateFingerprint();
+    reverseCsr.updateFingerprint();
+
+    csrValid = true;
+}
+
+template<class T, class W>
+const BasicCsrGraph<W>& Graph<T, W>::getCsr() const {
+    return csr;
+}
+
+template<class T, class W>
+const BasicCsrGraph<W>& Graph<T, W>::getReverseCsr() const {
+    return reverseCsr;
+}
+
+/**
+ * @brief Calculates the shortest path from a given vertex to all others using Dijkstra's algorithm, without modifying
+ * the graph. The graph must be frozen.
+ * @param source        pointer to the source vertex
+ * @param workspace     workspace where the distances and predecessors (indexed by vertex index) are left
+ */
+template<class T, class W>
+void Graph<T, W>::dijkstra(const Vertex<T, W>* source, BasicSearchWorkspace<W>& workspace) const {
+    if (!csrValid) {
+        std::cerr << "Graph must be frozen before running const queries" << std::endl;
+        exit(1);
+    }
+
+    dijkstraOverCsr(csr, source->index, workspace);
+}
+
+/**
+ * @brief Calculates the shortest path from a given vertex to all others using Dijkstra's algorithm with a given
+ * priority queue (e.g. RadixHeap or DialQueue), without modifying the graph. The graph must be frozen.
+ * @param source        pointer to the source vertex
+ * @param workspace     workspace where the distances and predecessors (indexed by vertex index) are left
+ * @param queue         priority queue used by the search
+ */
+template<class T, class W>
+template<class Queue>
+void Graph<T, W>::dijkstra(const Vertex<T, W>* source, BasicSearchWorkspace<W>& workspace, Queue& queue) const {
+    if (!csrValid) {
+        std::cerr << "Graph must be frozen before running const queries" << std::endl;
+        exit(1);
+    }
+
+    dijkstraOverCsr(csr, source->index, workspace, queue);
+}
+
+/**
+ * @brief Calculates the shortest paths from a given vertex to a set of targets using Dijkstra's algorithm, stopping as
+ * soon as all targets are settled and ignoring paths longer than a cutoff. Targets that are unreachable or further
+ * than the cutoff are left at infinity. The graph must be frozen.
+ * @param source        pointer to the source vertex
+ * @param targets       indices of the target vertices
+ * @param cutoff        maximum distance of interest
+ * @param workspace     workspace where the distances and predecessors (indexed by vertex index) are left
+ */
+template<class T, class W>
+void Graph<T, W>::dijkstra(const Vertex<T, W>* source, const std::vector<uint32_t>& targets, W cutoff,
+                           BasicSearchWorkspace<W>& workspace) const {
+    if (!csrValid) {
+        std::cerr << "Graph must be frozen before running const queries" << std::endl;
+        exit(1);
+    }
+
+    dijkstraOverCsr(csr, source->index, targets, cutoff, workspace);
+}
+
+/**
+ * @brief Calculates the shortest path between two vertices with the A* algorithm. The graph must be frozen.
+ * @param source        pointer to the source vertex
+ * @param target        pointer to the target vertex
+ * @param heuristic     function receiving the information of a vertex and of the target and returning a lower bound of
+ * the distance between them (e.g. the straight-line distance, when edge weights are geometric distances)
+ * @param cutoff        paths longer than this are ignored
+ * @param workspace     workspace used for the search
+ * @param path          if not null, filled with the vertices of the path, from the source to the target
+ * @return              distance from the source to the target, or infinity if it is greater than the cutoff
+ */
+template<class T, class W>
+template<class Heuristic>
+W Graph<T, W>::astar(const Vertex<T, W>* source, const Vertex<T, W>* target, const Heuristic& heuristic, W cutoff,
+                     BasicSearchWorkspace<W>& workspace, std::vector<Vertex<T, W>*>* path) const {
+    if (!csrValid) {
+        std::cerr << "Graph must be frozen before running const queries" << std::endl;
+        exit(1);
+    }
+
+    W dist = astarOverCsr(csr, source->index, target->index, [&](uint32_t v) {
+        return heuristic(vertexSet[v]->info, target->info);
+    }, cutoff, workspace);
+
+    if (path != nullptr) {
+        path->clear();
+        if (dist != WeightTraits<W>::infinity()) {
+            for (uint32_t v = target->index; v != NO_VERTEX; v = workspace.getPred(v)) {
+                path->push_back(vertexSet[v]);
             }
+            std::reverse(path->begin(), path->end());
         }
     }
+
+    return dist;
 }
 
 /**
- * @brief Calculates the shortest paths for every pair of vertices, creating adjacency matrices.
- * @param weight    adjacency matrix for the cost of the paths
- * @param path      adjacency matrix for the next vertex in the paths
+ * @brief Calculates the shortest path between two vertices with a bidirectional Dijkstra search. The graph must be
+ * frozen.
+ * @param source        pointer to the source vertex
+ * @param target        pointer to the target vertex
+ * @param cutoff        paths longer than this are ignored
+ * @param forward       workspace used for the forward search
+ * @param backward      workspace used for the backward search
+ * @param path          if not null, filled with the vertices of the path, from the source to the target
+ * @return              distance from the source to the target, or infinity if it is greater than the cutoff
  */
-template<class T>
-void Graph<T>::floydWarshallShortestPath(std::vector<std::vector<float>> & weight, std::vector<std::vector<int>> & path) {
-    unsigned n = vertexSet.size();
+template<class T, class W>
+W Graph<T, W>::bidirectionalDijkstra(const Vertex<T, W>* source, const Vertex<T, W>* target, W cutoff,
+                                     BasicSearchWorkspace<W>& forward, BasicSearchWorkspace<W>& backward,
+                                     std::vector<Vertex<T, W>*>* path) const {
+    if (!csrValid) {
+        std::cerr << "Graph must be frozen before running const queries" << std::endl;
+        exit(1);
+    }
 
-    for (unsigned i = 0; i < n; i++) {
-        for (Edge<T> e : vertexSet[i]->adj) {
-            int j = findVertexIdx(e.dest->info);
-            weight[i][j] = e.weight;
-            path  [i][j] = i;
+    uint32_t meeting;
+    W dist = bidirectionalDijkstraOverCsr(csr, reverseCsr, source->index, target->index, cutoff,
+                                          forward, backward, meeting);
+
+    if (path != nullptr) {
+        path->clear();
+        for (uint32_t v : bidirectionalPath(forward, backward, meeting)) {
+            path->push_back(vertexSet[v]);
         }
     }
 
-    for (unsigned k = 0; k < n; k++) {
-        for (unsigned i = 0; i < n; i++) {
-            for (unsigned j = 0; j < n; j++) {
-                if (weight[i][k] == MAX_FLOAT || weight[k][j] == MAX_FLOAT)
-                    continue; // avoid overflow
-                int val = weight[i][k] + weight[k][j];
-                if (val < weight[i][j]) {
-                    weight[i][j] = val;
-                    path  [i][j] = path[k][j];
-                }
+    return dist;
+}
+
+/**
+ * @brief Calculates the shortest path between two vertices with a query on a contraction hierarchy built from this
+ * graph. The graph must be frozen.
+ * @param hierarchy     hierarchy built from the CSR representation of the graph
+ * @param source        pointer to the source vertex
+ * @param target        pointer to the target vertex
+ * @param forward       workspace used for the forward search
+ * @param backward      workspace used for the backward search
+ * @param path          if not null, filled with the vertices of the path, from the source to the target
+ * @return              distance from the source to the target, or infinity if it is unreachable
+ */
+template<class T, class W>
+W Graph<T, W>::contractionHierarchyQuery(const ContractionHierarchy& hierarchy, const Vertex<T, W>* source,
+                                         const Vertex<T, W>* target, BasicSearchWorkspace<W>& forward,
+                                         BasicSearchWorkspace<W>& backward, std::vector<Vertex<T, W>*>* path) const {
+    if (!csrValid || !hierarchy.matches(csr)) {
+        std::cerr << "Graph must be frozen and match the hierarchy before running hierarchy queries" << std::endl;
+        exit(1);
+    }
+
+    if (path == nullptr) {
+        return hierarchy.query(source->index, target->index, forward, backward);
+    }
+
+    std::vector<uint32_t> indexPath;
+    W dist = hierarchy.query(source->index, target->index, forward, backward, &indexPath);
+
+    path->clear();
+    for (uint32_t v : indexPath) {
+        path->push_back(vertexSet[v]);
+    }
+
+    return dist;
+}
+
+/**
+ * @brief Calculates the shortest path between two vertices with the ALT algorithm, i.e. A* guided by the lower bounds
+ * of a set of landmarks, which need no coordinates and hold for any non-negative weights. The graph must be frozen and
+ * unchanged since the landmarks were chosen.
+ * @param landmarks     landmarks chosen on the CSR representation of the graph
+ * @param source        pointer to the source vertex
+ * @param target        pointer to the target vertex
+ * @param cutoff        paths longer than this are ignored
+ * @param workspace     workspace used for the search
+ * @param path          if not null, filled with the vertices of the path, from the source to the target
+ * @return              distance from the source to the target, or infinity if it is greater than the cutoff
+ */
+template<class T, class W>
+W Graph<T, W>::altQuery(const Landmarks& landmarks, const Vertex<T, W>* source, const Vertex<T, W>* target, W cutoff,
+                        BasicSearchWorkspace<W>& workspace, std::vector<Vertex<T, W>*>* path) const {
+    if (!csrValid || !landmarks.matches(csr)) {
+        std::cerr << "Graph must be frozen and match the landmarks before running landmark queries" << std::endl;
+        exit(1);
+    }
+
+    uint32_t targetIndex = target->index;
+    W dist = astarOverCsr(csr, source->index, targetIndex, [&](uint32_t v) {
+        return landmarks.lowerBound(v, targetIndex);
+    }, cutoff, workspace);
+
+    if (path != nullptr) {
+        path->clear();
+        if (dist != WeightTraits<W>::infinity()) {
+            for (uint32_t v = targetIndex; v != NO_VERTEX; v = workspace.getPred(v)) {
+                path->push_back(vertexSet[v]);
             }
+            std::reverse(path->begin(), path->end());
         }
     }
+
+    return dist;
 }
 
-template<class T>
-std::vector<std::vector<float>> Graph<T>::initializeFloydWarshallWeightVector() {
-    std::vector<std::vector<float>> weight;
-    std::vector<float> aux;
-    for (int i = 0; i < vertexSet.size(); ++ i) {
-        for (int j = 0; j < vertexSet.size(); ++j) {
-            if (i == j) {
-                aux.push_back(0);
-            } else {
-                aux.push_back(MAX_FLOAT);
+/**
+ * @brief Calculates the shortest path from a given vertex to all others using
+ * Dijkstra's algorithm, storing the results in the vertices themselves. Successive calls reuse the same search state,
+ * so each of them only costs the vertices reached by it and by the previous call.
+ * @param source    source vertex information
+ */
+template<class T, class W>
+void Graph<T, W>::dijkstraShortestPath(const T& source) {
+    dijkstraShortestPath(source, pathWorkspace.queue);
+}
+
+/**
+ * @brief Version of dijkstraShortestPath with a given priority queue: any of the policies of HeapPolicies.h, or a
+ * monotone queue (RadixHeap, or DialQueue, which must be created after the graph is frozen). The heap_benchmark target
+ * compares them on the grid maps and on random graphs.
+ * @param source    source vertex information
+ * @param queue     priority queue used by the search
+ */
+template<class T, class W>
+template<class Queue>
+void Graph<T, W>::dijkstraShortestPath(const T& source, Queue& queue) {
+    // Only the vertices reached by the previous search have to be reset
+    for (uint32_t v : pathReachedVertices) {
+        vertexSet[v]->dist = WeightTraits<W>::infinity();
+        vertexSet[v]->path = nullptr;
+    }
+    pathReachedVertices.clear();
+
+    int sourceIdx = findVertexIdx(source);
+    if (sourceIdx == -1)
+        return;
+
+    freeze();
+    dijkstra(vertexSet[sourceIdx], pathWorkspace, queue);
+
+    for (uint32_t v : pathWorkspace.reachedVertices) {
+        uint32_t pred = pathWorkspace.getPred(v);
+        vertexSet[v]->dist = pathWorkspace.getDist(v);
+        vertexSet[v]->path = pred == NO_VERTEX ? nullptr : vertexSet[pred];
+    }
+    pathReachedVertices = pathWorkspace.reachedVertices;
+}
+
+/**
+ * @brief Calculates the shortest paths for every pair of vertices, creating adjacency matrices.
+ * @param weight    adjacency matrix for the cost of the paths, as created by initializeFloydWarshallWeightMatrix
+ * @param path      adjacency matrix for the previous vertex in the paths (the predecessor of j in the path from i is in
+ * position (i, j)), as created by initializeFloydWarshallPathMatrix
+ * @param pool      if not null, the algorithm runs in parallel on the workers of the pool
+ */
+template<class T, class W>
+void Graph<T, W>::floydWarshallShortestPath(FlatMatrix<W> & weight, FlatMatrix<int32_t> & path, ThreadPool* pool) {
+    freeze();
+    unsigned n = csr.numVertices();
+
+    for (unsigned i = 0; i < n; i++) {
+        for (uint32_t e = csr.edgesBegin(i); e < csr.edgesEnd(i); ++e) {
+            uint32_t j = csr.dest[e];
+            if (csr.weight[e] < weight[i][j]) {
+                weight[i][j] = csr.weight[e];
+                path  [i][j] = i;
             }
         }
-        weight.push_back(aux);
-        aux.clear();
+    }
+
+    floydWarshallBlocked(weight, path, pool);
+}
+
+template<class T, class W>
+FlatMatrix<W> Graph<T, W>::initializeFloydWarshallWeightMatrix() const {
+    FlatMatrix<W> weight(vertexSet.size(), vertexSet.size(), WeightTraits<W>::infinity());
+    for (size_t i = 0; i < vertexSet.size(); ++i) {
+        weight[i][i] = 0;
     }
     return weight;
 }
 
-template<class T>
-std::vector<std::vector<int>> Graph<T>::initializeFloydWarshallPathVector() {
-    std::vector<std::vector<int>> path;
-    std::vector<int> aux;
-    for (int i = 0; i < vertexSet.size(); ++ i) {
-        for (int j = 0; j < vertexSet.size(); ++j) {
-            if (i == j) {
-                aux.push_back(i);
-            }
-            else {
-                aux.push_back(-1);
-            }
-        }
-        path.push_back(aux);
-        aux.clear();
+template<class T, class W>
+FlatMatrix<int32_t> Graph<T, W>::initializeFloydWarshallPathMatrix() const {
+    FlatMatrix<int32_t> path(vertexSet.size(), vertexSet.size(), -1);
+    for (size_t i = 0; i < vertexSet.size(); ++i) {
+        path[i][i] = i;
     }
     return path;
 }
 
+/**
+ * @brief Rebuilds a shortest path from the predecessor matrix of the Floyd-Warshall algorithm, walking back from the
+ * target through the row of the source, in time linear in the length of the path.
+ * @param path      predecessor matrix filled by floydWarshallShortestPath
+ * @param source    pointer to the first vertex of the path
+ * @param target    pointer to the last vertex of the path
+ * @param output    filled with the vertices of the path, from the source to the target
+ * @return          false if there is no path, in which case the output is left empty
+ */
+template<class T, class W>
+bool Graph<T, W>::floydWarshallPath(const FlatMatrix<int32_t>& path, const Vertex<T, W>* source,
+                                    const Vertex<T, W>* target, std::vector<Vertex<T, W>*>& output) const {
+    output.clear();
+    // Entries of the predecessor matrix are signed, since -1 marks a missing path
+    const int32_t sourceIndex = static_cast<int32_t>(source->index);
+
+    for (int32_t v = static_cast<int32_t>(target->index); v != sourceIndex; v = path[sourceIndex][v]) {
+        if (v == -1) {
+            output.clear();
+            return false;
+        }
+        output.push_back(vertexSet[v]);
+    }
+    output.push_back(vertexSet[source->index]);
+
+    std::reverse(output.begin(), output.end());
+    return true;
+}
+
+/**
+ * @brief Repairs the matrices of the Floyd-Warshall algorithm after the edges from one vertex to another were updated
+ * or removed, instead of running the algorithm again. Each row of the predecessor matrix is the shortest path tree of
+ * its vertex, so only the rows whose trees the change affects are repaired (see repairShortestPathTree), each of them
+ * re-settling only the vertices whose distances may have changed. Must be called after each change.
+ * @param weight    matrix of the cost of the shortest paths, filled by floydWarshallShortestPath
+ * @param path      predecessor matrix, filled by floydWarshallShortestPath
+ * @param source    pointer to the vertex the changed edges leave
+ * @param dest      pointer to the vertex the changed edges enter
+ * @param pool      if not null, the rows are repaired in parallel by the workers of the pool
+ */
+template<class T, class W>
+void Graph<T, W>::repairFloydWarshall(FlatMatrix<W> & weight, FlatMatrix<int32_t> & path, const Vertex<T, W>* source,
+                                      const Vertex<T, W>* dest, ThreadPool* pool) {
+    freeze();
+
+    auto repairRow = [&](BasicSearchWorkspace<W>& workspace, size_t row) {
+        repairShortestPathTree<int32_t>(csr, reverseCsr, row, source->index, dest->index, weight[row], path[row], -1,
+                                        workspace);
+    };
+
+    if (pool != nullptr) {
+        std::vector<BasicSearchWorkspace<W>> workspaces(pool->size());
+        pool->parallelFor(csr.numVertices(), [&](unsigned worker, size_t row) {
+            repairRow(workspaces[worker], row);
+        });
+    }
+    else {
+        BasicSearchWorkspace<W> workspace;
+        for (size_t row = 0; row < csr.numVertices(); ++row) {
+            repairRow(workspace, row);
+        }
+    }
+}
+
 /**
  * @brief Generates the adjacency matrix required for the CCTSP problem with repeated applications of Dijkstra's
- * shortest path, choosing the start vertex and then each point of interest as the source
+ * shortest path, choosing the start vertex and then each point of interest as the source. The entries have the weight
+ * type M of the CCTSP step (see WeightTraits), converted from the distances of the searches as they are stored
+ * @param pointsOfInterest      list of pointers to vertices which are points of interest
+ * @param start                 pointer to start vertex
+ * @param finish                pointer to finish vertex
+ * @param cutoff                distances greater than this (e.g. the budget) are not needed and are left at infinity
+ * @param trees                 if not null, keeps the shortest path trees of the searches (tree i has the paths from
+ * the source of row i to the finish vertex and to the points of interest), so the paths can be rebuilt without searching
+ * @return                      adjacency matrix with shortest paths between all points of interest
+ */
+template <class T, class W>
+template <class M>
+std::vector<std::vector<M>> Graph<T, W>::generateAdjacencyMatrixWithDijkstra(
+        const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish, W cutoff,
+        PredecessorTrees* trees) {
+    std::vector<std::vector<M>> adjacencyMatrix(pointsOfInterest.size() + 1,
+            std::vector<M>(pointsOfInterest.size() + 1));
+
+    freeze();
+    BasicSearchWorkspace<W> workspace;
+    std::vector<uint32_t> targets = adjacencyMatrixTargets(pointsOfInterest, finish);
+    if (trees != nullptr) {
+        trees->resize(adjacencyMatrix.size(), csr.numVertices());
+    }
+
+    for (size_t row = 0; row < adjacencyMatrix.size(); ++row) {
+        fillAdjacencyMatrixRow(pointsOfInterest, start, finish, targets, cutoff, row, workspace, adjacencyMatrix[row],
+                               trees);
+    }
+
+    return adjacencyMatrix;
+}
+
+/**
+ * @brief Multithreaded version of generateAdjacencyMatrixWithDijkstra. The rows of the matrix are independent, so
+ * they are distributed among the workers of the pool, each of them searching with its own workspace and writing
+ * directly into the rows of the output matrix.
+ * @param pool                  thread pool where the searches are run
+ */
+template <class T, class W>
+template <class M>
+std::vector<std::vector<M>> Graph<T, W>::generateAdjacencyMatrixWithDijkstra(
+        const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish,
+        ThreadPool& pool, W cutoff, PredecessorTrees* trees) {
+    std::vector<std::vector<M>> adjacencyMatrix(pointsOfInterest.size() + 1,
+            std::vector<M>(pointsOfInterest.size() + 1));
+
+    freeze();
+    std::vector<BasicSearchWorkspace<W>> workspaces(pool.size());
+    std::vector<uint32_t> targets = adjacencyMatrixTargets(pointsOfInterest, finish);
+    if (trees != nullptr) {
+        trees->resize(adjacencyMatrix.size(), csr.numVertices());
+    }
+
+    pool.parallelFor(adjacencyMatrix.size(), [&](unsigned worker, size_t row) {
+        fillAdjacencyMatrixRow(pointsOfInterest, start, finish, targets, cutoff, row, workspaces[worker],
+                               adjacencyMatrix[row], trees);
+    });
+
+    return adjacencyMatrix;
+}
+
+/**
+ * @brief Generates the adjacency matrix required for the CCTSP problem with a contraction hierarchy query for each
+ * pair of vertices, in the same format as generateAdjacencyMatrixWithDijkstra
  * @param pointsOfInterest      list of pointers to vertices which are points of interest
  * @param start                 pointer to start vertex
  * @param finish                pointer to finish vertex
+ * @param hierarchy             hierarchy built from the CSR representation of the graph
  * @return                      adjacency matrix with shortest paths between all points of interest
  */
-template <class T>
-std::vector<std::vector<float>> Graph<T>::generateAdjacencyMatrixWithDijkstra(
-        const std::vector<Vertex<T>*>& pointsOfInterest, Vertex<T> * start, Vertex<T> * finish) {
-    std::vector<std::vector<float>> adjacencyMatrix;
-    adjacencyMatrix.resize(pointsOfInterest.size() + 1);
-
-    // We construct the adjacency matrix line to line
-    // Starting with the start vertex
-    dijkstraShortestPath(start->getInfo());
-    adjacencyMatrix[0].push_back(start->getDist());
-    for (Vertex<T>* POI : pointsOfInterest) {
-        adjacencyMatrix[0].push_back(POI->getDist());
-    }
-
-    for (int i = 0; i < pointsOfInterest.size(); ++i) {
-        // And then all the other POIs
-        // The first value corresponds to the distance from the POI to the finish vertex
-        //     Which will be the distance to the start vertex when we look at it in the loop format
-        dijkstraShortestPath(pointsOfInterest[i]->getInfo());
-        adjacencyMatrix[i + 1].push_back(finish->getDist());
-        for (int j = 0; j < pointsOfInterest.size(); ++j) {
-            adjacencyMatrix[i + 1].push_back(pointsOfInterest[j]->getDist());
+template <class T, class W>
+template <class M>
+std::vector<std::vector<M>> Graph<T, W>::generateAdjacencyMatrixWithContractionHierarchy(
+        const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish,
+        const ContractionHierarchy& hierarchy) {
+    std::vector<std::vector<M>> adjacencyMatrix(pointsOfInterest.size() + 1,
+            std::vector<M>(pointsOfInterest.size() + 1));
+
+    freeze();
+    // Checked once for the whole matrix, so the queries below go straight to the hierarchy
+    if (!hierarchy.matches(csr)) {
+        std::cerr << "The hierarchy must match the graph" << std::endl;
+        exit(1);
+    }
+    BasicSearchWorkspace<W> forward, backward;
+
+    for (size_t row = 0; row < adjacencyMatrix.size(); ++row) {
+        const uint32_t source = row == 0 ? start->index : pointsOfInterest[row - 1]->index;
+
+        adjacencyMatrix[row][0] = row == 0 ? 0 :
+                convertWeight<M>(hierarchy.query(source, finish->index, forward, backward));
+        for (size_t j = 0; j < pointsOfInterest.size(); ++j) {
+            adjacencyMatrix[row][j + 1] = convertWeight<M>(
+                    hierarchy.query(source, pointsOfInterest[j]->index, forward, backward));
         }
     }
 
@@ -345,51 +948,264 @@ std::vector<std::vector<float>> Graph<T>::generateAdjacencyMatrixWithDijkstra(
 }
 
 /**
- * @brief Generates the adjacency matrix required for the CCTSP problem by filtering the adjacency matrix generated by
- * the Floyd-Warshall algorithm, selecting only vertices which are points of interest
+ * @brief Generates the adjacency matrix required for the CCTSP problem with a single many-to-many query from the start
+ * vertex and the points of interest to the finish vertex and the points of interest, in the same format as
+ * generateAdjacencyMatrixWithDijkstra. The query runs on the contraction hierarchy if one is given, and on the graph and
+ * its reverse otherwise.
+ * @param pointsOfInterest      list of pointers to vertices which are points of interest
+ * @param start                 pointer to start vertex
+ * @param finish                pointer to finish vertex
+ * @param cutoff                distances greater than this (e.g. the budget) are not needed and are left at infinity
+ * @param hierarchy             hierarchy built from the CSR representation of the graph, or null (always null on
+ * graphs whose weights are not floats)
+ * @return                      adjacency matrix with shortest paths between all points of interest
+ */
+template <class T, class W>
+template <class M>
+std::vector<std::vector<M>> Graph<T, W>::generateAdjacencyMatrixWithManyToMany(
+        const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish, W cutoff,
+        const ContractionHierarchy* hierarchy) {
+    freeze();
+
+    // Row 0 and column 0 correspond to the start and the finish vertices, respectively
+    std::vector<uint32_t> sources, targets = adjacencyMatrixTargets(pointsOfInterest, finish);
+    sources.reserve(targets.size());
+    sources.push_back(start->index);
+    sources.insert(sources.end(), targets.begin() + 1, targets.end());
+
+    BasicSearchWorkspace<W> workspace;
+    std::vector<std::vector<M>> adjacencyMatrix = manyToManyQuery<M>(hierarchy, csr, reverseCsr, sources, targets,
+                                                                     cutoff, workspace);
+
+    // The first value of row 0 is the distance from the start vertex to itself
+    adjacencyMatrix[0][0] = 0;
+    return adjacencyMatrix;
+}
+
+/**
+ * @brief Generates the adjacency matrix required for the CCTSP problem from the cached rows of the points of interest,
+ * in the same format as generateAdjacencyMatrixWithDijkstra and without any search: the rows of the points of interest
+ * come from their forward rows, and row 0 (from the start vertex) from their reverse rows.
  * @param pointsOfInterest      list of pointers to vertices which are points of interest
  * @param start                 pointer to start vertex
  * @param finish                pointer to finish vertex
+ * @param cache                 rows of (at least) the points of interest, computed on the current graph
  * @return                      adjacency matrix with shortest paths between all points of interest
  */
-template <class T>
-std::vector<std::vector<float>> Graph<T>::generateAdjacencyMatrixWithFloydWarshall(const std::vector<Vertex<T>*>& pointsOfInterest, Vertex<T> * start, Vertex<T> * finish) {
-    std::vector<std::vector<float>> adjacencyMatrix;
-    std::vector<float> aux;
+template <class T, class W>
+template <class M>
+std::vector<std::vector<M>> Graph<T, W>::generateAdjacencyMatrixFromCache(
+        const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish,
+        const DistanceRowCache& cache) {
+    freeze();
+    std::vector<uint32_t> poiIndex = pointOfInterestIndices(pointsOfInterest);
+    std::vector<size_t> rows;
+    rows.reserve(poiIndex.size());
+    for (uint32_t v : poiIndex) {
+        rows.push_back(cache.findRow(v));
+    }
 
-    std::vector<std::vector<float>> weight = initializeFloydWarshallWeightVector();
-    std::vector<std::vector< int  >>  path  = initializeFloydWarshallPathVector();
-    floydWarshallShortestPath(weight, path);
+    if (!cache.matches(csr) ||
+        std::find(rows.begin(), rows.end(), DistanceRowCache::NO_ROW) != rows.end()) {
+        std::cerr << "The cache must have the rows of the points of interest on the current graph" << std::endl;
+        exit(1);
+    }
+
+    std::vector<std::vector<M>> adjacencyMatrix(poiIndex.size() + 1, std::vector<M>(poiIndex.size() + 1));
 
-    int startIndex  = findVertexIdx(start->getInfo());
-    int finishIndex = findVertexIdx(finish->getInfo());
+    adjacencyMatrix[0][0] = 0;
+    for (size_t j = 0; j < poiIndex.size(); ++j) {
+        adjacencyMatrix[0][j + 1] = convertWeight<M>(cache.reverseDist(rows[j], start->index));
+    }
 
-    // We construct the adjacency matrix line to line
-    // Starting with the start vertex
-    aux.push_back(0);
-    for (int j = 0; j < vertexSet.size(); ++ j) {
-        if (vertexSet[j]->isPOI(pointsOfInterest)) {
-            aux.push_back(weight[startIndex][j]);
+    for (size_t i = 0; i < poiIndex.size(); ++i) {
+        adjacencyMatrix[i + 1][0] = convertWeight<M>(cache.forwardDist(rows[i], finish->index));
+        for (size_t j = 0; j < poiIndex.size(); ++j) {
+            adjacencyMatrix[i + 1][j + 1] = convertWeight<M>(cache.forwardDist(rows[i], poiIndex[j]));
         }
     }
-    adjacencyMatrix.push_back(aux);
-    aux.clear();
-
-    for (int i = 0; i < vertexSet.size(); ++ i) {
-        // And then all the other POIs
-        // The first value corresponds to the distance from the POI to the finish vertex
-        //     Which will be the distance to the start vertex when we look at it in the loop format
-        if (vertexSet[i]->isPOI(pointsOfInterest)) {
-            aux.push_back(weight[i][finishIndex]);
-            for (int j = 0; j < vertexSet.size(); ++ j) {
-                if (vertexSet[j]->isPOI(pointsOfInterest)) {
-                    aux.push_back(weight[i][j]);
-                }
-            }
-            adjacencyMatrix.push_back(aux);
-            aux.clear();
+
+    return adjacencyMatrix;
+}
+
+/**
+ * @brief Finds the points of interest which can be part of a trip within the budget, i.e. those inside the ellipse
+ * dist(start, POI) + dist(POI, finish) <= budget. The others are never in a feasible tour, so they can be left out of
+ * the reduction step and of the CCTSP step. The distances come from a forward search from the start vertex and a
+ * backward search from the finish vertex (on the reverse graph), both stopping at the budget, or from the cached rows
+ * of the points of interest, if the cache has all of them. With landmarks, the points of interest whose lower bounds
+ * already exceed the budget are dropped first, and are not targets of the searches. The graph must be frozen.
+ * @param pointsOfInterest      list of pointers to vertices which are points of interest
+ * @param start                 pointer to start vertex
+ * @param finish                pointer to finish vertex
+ * @param budget                maximum cost of the trip
+ * @param cache                 if not null, rows of (at least) the points of interest, used instead of searching
+ * @param landmarks             if not null, landmarks chosen on this graph, used to drop points of interest early
+ * @return                      positions in the list of the points of interest which can be visited
+ */
+template <class T, class W>
+std::vector<size_t> Graph<T, W>::feasiblePointsOfInterest(const std::vector<Vertex<T, W>*>& pointsOfInterest,
+        const Vertex<T, W>* start, const Vertex<T, W>* finish, W budget, const DistanceRowCache* cache,
+        const Landmarks* landmarks) const {
+    if (!csrValid) {
+        std::cerr << "Graph must be frozen before running const queries" << std::endl;
+        exit(1);
+    }
+
+    std::vector<uint32_t> poiIndex = pointOfInterestIndices(pointsOfInterest);
+
+    std::vector<size_t> candidates;
+    bool bounded = landmarks != nullptr && landmarks->matches(csr);
+    for (size_t i = 0; i < poiIndex.size(); ++i) {
+        if (!bounded || landmarks->lowerBound(start->index, poiIndex[i]) +
+                        landmarks->lowerBound(poiIndex[i], finish->index) <= budget) {
+            candidates.push_back(i);
+        }
+    }
+
+    std::vector<W> fromStart(candidates.size()), toFinish(candidates.size());
+
+    bool cached = cache != nullptr && cache->matches(csr);
+    for (size_t i = 0; cached && i < candidates.size(); ++i) {
+        cached = cache->findRow(poiIndex[candidates[i]]) != DistanceRowCache::NO_ROW;
+    }
+
+    if (cached) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            size_t row = cache->findRow(poiIndex[candidates[i]]);
+            fromStart[i] = cache->reverseDist(row, start->index);
+            toFinish[i] = cache->forwardDist(row, finish->index);
         }
     }
+    else {
+        std::vector<uint32_t> targets;
+        targets.reserve(candidates.size());
+        for (size_t i : candidates) {
+            targets.push_back(poiIndex[i]);
+        }
+
+        BasicSearchWorkspace<W> forward, backward;
+        dijkstraOverCsr(csr, start->index, targets, budget, forward);
+        dijkstraOverCsr(reverseCsr, finish->index, targets, budget, backward);
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            fromStart[i] = forward.getDist(targets[i]);
+            toFinish[i] = backward.getDist(targets[i]);
+        }
+    }
+
+    std::vector<size_t> feasible;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (fromStart[i] != WeightTraits<W>::infinity() && toFinish[i] != WeightTraits<W>::infinity() &&
+            WeightTraits<W>::add(fromStart[i], toFinish[i]) <= budget) {
+            feasible.push_back(candidates[i]);
+        }
+    }
+    return feasible;
+}
+
+/**
+ * @brief Lists the vertices whose distances are needed for the adjacency matrix (the finish vertex and the points of
+ * interest), which are the targets of the searches of each row.
+ */
+template <class T, class W>
+std::vector<uint32_t> Graph<T, W>::adjacencyMatrixTargets(const std::vector<Vertex<T, W>*>& pointsOfInterest,
+        const Vertex<T, W>* finish) const {
+    std::vector<uint32_t> poiIndex = pointOfInterestIndices(pointsOfInterest);
+    std::vector<uint32_t> targets;
+    targets.reserve(poiIndex.size() + 1);
+    targets.push_back(finish->index);
+    targets.insert(targets.end(), poiIndex.begin(), poiIndex.end());
+    return targets;
+}
+
+/**
+ * @brief Calculates one row of the adjacency matrix required for the CCTSP problem. Row 0 has the distances from the
+ * start vertex and row i has the distances from the (i - 1)-th point of interest. The first value of each row
+ * corresponds to the distance to the finish vertex, which will be the distance to the start vertex when we look at it
+ * in the loop format (for row 0 it is simply 0).
+ * @param targets       targets of the search, as returned by adjacencyMatrixTargets
+ * @param cutoff        maximum distance of interest
+ * @param row           index of the row
+ * @param workspace     workspace used for the search
+ * @param output        row of the matrix, with one more element than the number of points of interest
+ * @param trees         if not null, the shortest path tree of the search is kept in it, in the position of the row
+ */
+template <class T, class W>
+template <class M>
+void Graph<T, W>::fillAdjacencyMatrixRow(const std::vector<Vertex<T, W>*>& pointsOfInterest, const Vertex<T, W>* start,
+        const Vertex<T, W>* finish, const std::vector<uint32_t>& targets, W cutoff, size_t row,
+        BasicSearchWorkspace<W>& workspace, std::vector<M>& output, PredecessorTrees* trees) const {
+    const Vertex<T, W>* source = row == 0 ? start : pointsOfInterest[row - 1];
+
+    dijkstra(source, targets, cutoff, workspace);
+
+    output[0] = convertWeight<M>(workspace.getDist(row == 0 ? start->index : finish->index));
+    for (size_t j = 0; j < pointsOfInterest.size(); ++j) {
+        output[j + 1] = convertWeight<M>(workspace.getDist(pointsOfInterest[j]->index));
+    }
+
+    if (trees != nullptr) {
+        trees->store(row, source->index, targets, workspace);
+    }
+}
+
+/**
+ * @brief Generates the adjacency matrix required for the CCTSP problem by filtering the adjacency matrix generated by
+ * the Floyd-Warshall algorithm, selecting only vertices which are points of interest
+ * @param pointsOfInterest      list of pointers to vertices which are points of interest
+ * @param start                 pointer to start vertex
+ * @param finish                pointer to finish vertex
+ * @param pool                  if not null, the Floyd-Warshall algorithm runs on the workers of the pool
+ * @param path                  if not null, receives the predecessor matrix of the Floyd-Warshall algorithm, from which
+ * floydWarshallPath rebuilds the shortest paths without further searches
+ * @return                      adjacency matrix with shortest paths between all points of interest
+ */
+template <class T, class W>
+template <class M>
+std::vector<std::vector<M>> Graph<T, W>::generateAdjacencyMatrixWithFloydWarshall(const std::vector<Vertex<T, W>*>& pointsOfInterest, Vertex<T, W> * start, Vertex<T, W> * finish, ThreadPool* pool, FlatMatrix<int32_t> * path) {
+    FlatMatrix<W>   weight      = initializeFloydWarshallWeightMatrix();
+    FlatMatrix<int32_t> predecessor = initializeFloydWarshallPathMatrix();
+    floydWarshallShortestPath(weight, predecessor, pool);
+
+    if (path != nullptr) {
+        *path = std::move(predecessor);
+    }
+    return generateAdjacencyMatrixFromFloydWarshall<M>(pointsOfInterest, start, finish, weight);
+}
+
+/**
+ * @brief Generates the adjacency matrix required for the CCTSP problem from a weight matrix already computed by
+ * floydWarshallShortestPath, so the algorithm can be run once per map and reused for any number of trips
+ * @param pointsOfInterest      list of pointers to vertices which are points of interest
+ * @param start                 pointer to start vertex
+ * @param finish                pointer to finish vertex
+ * @param weight                weight matrix filled by floydWarshallShortestPath
+ * @return                      adjacency matrix with shortest paths between all points of interest
+ */
+template <class T, class W>
+template <class M>
+std::vector<std::vector<M>> Graph<T, W>::generateAdjacencyMatrixFromFloydWarshall(
+        const std::vector<Vertex<T, W>*>& pointsOfInterest, const Vertex<T, W> * start, const Vertex<T, W> * finish,
+        const FlatMatrix<W> & weight) const {
+    std::vector<uint32_t> poiIndex = pointOfInterestIndices(pointsOfInterest);
+    std::vector<std::vector<M>> adjacencyMatrix(poiIndex.size() + 1, std::vector<M>(poiIndex.size() + 1));
+
+    // Same layout as generateAdjacencyMatrixWithDijkstra: row 0 has the distances from the start vertex and row i those
+    // from the (i - 1)-th point of interest, and column 0 has the distances to the finish vertex (0 for row 0)
+    const W* startRow = weight[start->index];
+    adjacencyMatrix[0][0] = 0;
+    for (size_t j = 0; j < poiIndex.size(); ++j) {
+        adjacencyMatrix[0][j + 1] = convertWeight<M>(startRow[poiIndex[j]]);
+    }
+
+    for (size_t i = 0; i < poiIndex.size(); ++i) {
+        const W* row = weight[poiIndex[i]];
+        adjacencyMatrix[i + 1][0] = convertWeight<M>(row[finish->index]);
+        for (size_t j = 0; j < poiIndex.size(); ++j) {
+            adjacencyMatrix[i + 1][j + 1] = convertWeight<M>(row[poiIndex[j]]);
+        }
+    }
+
     return adjacencyMatrix;
 }
 
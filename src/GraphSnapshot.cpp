@@ -0,0 +1,386 @@
+#include "GraphSnapshot.h"
+
+#include <algorithm>
+#include <fstream>
+
+// Identifies snapshots ("GSNP"), followed by the version of the format
+static const uint32_t FILE_MAGIC = 0x47534E50;
+static const uint32_t FILE_VERSION = 2;
+
+// Sections start on cache line boundaries, like the rows of a FlatMatrix
+static const uint64_t SECTION_ALIGNMENT = 64;
+
+/**
+ * @brief Calculates the size in bytes of each section of a snapshot, from the counts in its header.
+ */
+void GraphSnapshot::sectionSizes(const Header& header, uint64_t sizes[NUM_SECTIONS]) {
+    const uint64_t n = header.numVertices, m = header.numEdges;
+    const uint64_t p = header.numPointsOfInterest, r = header.numRows;
+
+    sizes[IDS] = n * sizeof(uint32_t);
+    sizes[X] = n * sizeof(float);
+    sizes[Y] = n * sizeof(float);
+    sizes[OFFSETS] = (n + 1) * sizeof(uint32_t);
+    sizes[DEST] = m * sizeof(uint32_t);
+    sizes[WEIGHT] = m * sizeof(float);
+    sizes[REVERSE_OFFSETS] = (n + 1) * sizeof(uint32_t);
+    sizes[REVERSE_DEST] = m * sizeof(uint32_t);
+    sizes[REVERSE_WEIGHT] = m * sizeof(float);
+    sizes[POI_VERTICES] = p * sizeof(uint32_t);
+    sizes[POI_CATEGORIES] = p * sizeof(uint32_t);
+    sizes[ROW_SOURCES] = r * sizeof(uint32_t);
+    sizes[FORWARD_DISTANCES] = r * n * sizeof(float);
+    sizes[FORWARD_PRED] = r * n * sizeof(uint32_t);
+    sizes[REVERSE_DISTANCES] = r * n * sizeof(float);
+    sizes[REVERSE_SUCC] = r * n * sizeof(uint32_t);
+}
+
+namespace {
+
+/**
+ * Writes the sections of a snapshot one after the other, padding each to the position given in the header.
+ */
+class SectionWriter {
+public:
+    SectionWriter(std::ofstream& ofs, uint64_t position) : ofs(ofs), position(position) {}
+
+    void pad(uint64_t offset) {
+        static const char ZEROS[SECTION_ALIGNMENT] = {};
+        ofs.write(ZEROS, offset - position);
+        position = offset;
+    }
+
+    template<class E>
+    void write(const E* data, size_t count) {
+        ofs.write(reinterpret_cast<const char*>(data), count * sizeof(E));
+        position += count * sizeof(E);
+    }
+
+    template<class E>
+    void writeRows(const FlatMatrix<E>& matrix) {
+        for (size_t row = 0; row < matrix.numRows(); ++row) {
+            write(matrix[row], matrix.numCols());
+        }
+    }
+private:
+    std::ofstream& ofs;
+    uint64_t position;
+};
+
+/**
+ * @brief Checks that the arrays of a CSR graph are consistent: the offsets start at 0, never decrease and end at the
+ * number of edges, and every destination is a vertex.
+ */
+bool isValidCsr(const CsrView& csr) {
+    if (csr.offsets[0] != 0 || csr.offsets[csr.vertices] != csr.edges)
+        return false;
+
+    for (uint32_t v = 0; v < csr.vertices; ++v) {
+        if (csr.offsets[v] > csr.offsets[v + 1])
+            return false;
+    }
+    return std::all_of(csr.dest, csr.dest + csr.edges, [&csr](uint32_t v) {
+        return v < csr.vertices;
+    });
+}
+
+/**
+ * @brief Checks that every predecessor (or successor) in the rows of a cache is a vertex or NO_VERTEX.
+ */
+bool isValidTree(const FlatMatrix<uint32_t>& links, uint32_t numVertices) {
+    for (size_t row = 0; row < links.numRows(); ++row) {
+        if (!std::all_of(links[row], links[row] + numVertices, [numVertices](uint32_t v) {
+            return v < numVertices || v == NO_VERTEX;
+        }))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief Writes a snapshot of a map. The graph is frozen first, and its vertices are stored in the order of their
+ * indices, so a graph built from the snapshot has the same CSR arrays (and matches the same hierarchies and caches).
+ * @param path              path of the file
+ * @param graph             graph of the map
+ * @param pointsOfInterest  points of interest of the map
+ * @param categories        category of each point of interest
+ * @param sourceStamp       value returned by getSourceStamp when the snapshot is loaded
+ * @param rows              if not null and computed on the graph, distance rows stored with the snapshot
+ * @return                  true if the file was written successfully
+ */
+bool GraphSnapshot::write(const std::string& path, Graph<PosInfo>& graph,
+                          const std::vector<Vertex<PosInfo>*>& pointsOfInterest,
+                          const std::vector<POICategory>& categories, uint64_t sourceStamp,
+                          const DistanceRowCache* rows) {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs)
+        return false;
+
+    graph.freeze();
+    const CsrGraph& csr = graph.getCsr();
+    const CsrGraph& reverse = graph.getReverseCsr();
+    if (rows != nullptr && !rows->matches(csr)) {
+        rows = nullptr;
+    }
+
+    Header header = {};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.sourceStamp = sourceStamp;
+    header.numVertices = csr.numVertices();
+    header.numEdges = csr.numEdges();
+    header.numPointsOfInterest = pointsOfInterest.size();
+    header.numRows = rows != nullptr ? rows->numRows() : 0;
+    header.rowsFingerprint = rows != nullptr ? rows->fingerprint : 0;
+
+    uint64_t sizes[NUM_SECTIONS];
+    sectionSizes(header, sizes);
+    uint64_t offset = sizeof(Header);
+    for (int s = 0; s < NUM_SECTIONS; ++s) {
+        offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        header.sectionOffsets[s] = offset;
+        offset += sizes[s];
+    }
+
+    std::vector<uint32_t> ids(header.numVertices);
+    std::vector<float> x(header.numVertices), y(header.numVertices);
+    for (uint32_t v = 0; v < header.numVertices; ++v) {
+        const PosInfo& info = graph.getVertex(v)->getInfo();
+        ids[v] = info.getId();
+        x[v] = info.getX();
+        y[v] = info.getY();
+    }
+
+    std::vector<uint32_t> poiVertices, poiCategories;
+    for (size_t i = 0; i < pointsOfInterest.size(); ++i) {
+        poiVertices.push_back(pointsOfInterest[i]->getIndex());
+        poiCategories.push_back(categories[i]);
+    }
+
+    SectionWriter writer(ofs, 0);
+    writer.write(&header, 1);
+    writer.pad(header.sectionOffsets[IDS]);
+    writer.write(ids.data(), ids.size());
+    writer.pad(header.sectionOffsets[X]);
+    writer.write(x.data(), x.size());
+    writer.pad(header.sectionOffsets[Y]);
+    writer.write(y.data(), y.size());
+    writer.pad(header.sectionOffsets[OFFSETS]);
+    writer.write(csr.offsets.data(), csr.offsets.size());
+    writer.pad(header.sectionOffsets[DEST]);
+    writer.write(csr.dest.data(), csr.dest.size());
+    writer.pad(header.sectionOffsets[WEIGHT]);
+    writer.write(csr.weight.data(), csr.weight.size());
+    writer.pad(header.sectionOffsets[REVERSE_OFFSETS]);
+    writer.write(reverse.offsets.data(), reverse.offsets.size());
+    writer.pad(header.sectionOffsets[REVERSE_DEST]);
+    writer.write(reverse.dest.data(), reverse.dest.size());
+    writer.pad(header.sectionOffsets[REVERSE_WEIGHT]);
+    writer.write(reverse.weight.data(), reverse.weight.size());
+    writer.pad(header.sectionOffsets[POI_VERTICES]);
+    writer.write(poiVertices.data(), poiVertices.size());
+    writer.pad(header.sectionOffsets[POI_CATEGORIES]);
+    writer.write(poiCategories.data(), poiCategories.size());
+
+    if (rows != nullptr) {
+        writer.pad(header.sectionOffsets[ROW_SOURCES]);
+        writer.write(rows->sources.data(), rows->sources.size());
+        writer.pad(header.sectionOffsets[FORWARD_DISTANCES]);
+        writer.writeRows(rows->forwardDistances);
+        writer.pad(header.sectionOffsets[FORWARD_PRED]);
+        writer.writeRows(rows->forwardPred);
+        writer.pad(header.sectionOffsets[REVERSE_DISTANCES]);
+        writer.writeRows(rows->reverseDistances);
+        writer.pad(header.sectionOffsets[REVERSE_SUCC]);
+        writer.writeRows(rows->reverseSucc);
+    }
+    writer.pad(offset);
+
+    return static_cast<bool>(ofs);
+}
+
+/**
+ * @brief Maps a snapshot written by write. Besides the header, the offsets and destinations of both CSR graphs and the
+ * indices of the points of interest and of the row sources are checked, since the searches on the views and toGraph
+ * index the other arrays with them. That scan is linear in the size of the graph, but much faster than parsing the map.
+ * @return  true if the file is a valid snapshot of this version (otherwise, the snapshot is left empty)
+ */
+bool GraphSnapshot::load(const std::string& path) {
+    file.reset(new MappedFile(path));
+    header = reinterpret_cast<const Header*>(file->data());
+
+    bool success = file->size() >= sizeof(Header) && header->magic == FILE_MAGIC && header->version == FILE_VERSION;
+
+    uint64_t sizes[NUM_SECTIONS];
+    if (success) {
+        sectionSizes(*header, sizes);
+    }
+    for (int s = 0; success && s < NUM_SECTIONS; ++s) {
+        success = header->sectionOffsets[s] % SECTION_ALIGNMENT == 0 &&
+                  header->sectionOffsets[s] <= file->size() && sizes[s] <= file->size() - header->sectionOffsets[s];
+    }
+
+    if (success) {
+        const uint32_t n = header->numVertices;
+        success = isValidCsr(getCsr()) && isValidCsr(getReverseCsr());
+
+        const uint32_t* poiVertices = section<uint32_t>(POI_VERTICES);
+        const uint32_t* rowSources = section<uint32_t>(ROW_SOURCES);
+        success = success &&
+                  std::all_of(poiVertices, poiVertices + header->numPointsOfInterest, [n](uint32_t v) {
+                      return v < n;
+                  }) &&
+                  std::all_of(rowSources, rowSources + header->numRows, [n](uint32_t v) {
+                      return v < n;
+                  });
+    }
+
+    if (!success) {
+        file.reset();
+        header = nullptr;
+    }
+    return success;
+}
+
+uint64_t GraphSnapshot::getSourceStamp() const {
+    return header->sourceStamp;
+}
+
+uint32_t GraphSnapshot::numVertices() const {
+    return header->numVertices;
+}
+
+uint32_t GraphSnapshot::numEdges() const {
+    return header->numEdges;
+}
+
+unsigned int GraphSnapshot::getId(uint32_t v) const {
+    return section<uint32_t>(IDS)[v];
+}
+
+float GraphSnapshot::getX(uint32_t v) const {
+    return section<float>(X)[v];
+}
+
+float GraphSnapshot::getY(uint32_t v) const {
+    return section<float>(Y)[v];
+}
+
+CsrView GraphSnapshot::getCsr() const {
+    CsrView view;
+    view.offsets = section<uint32_t>(OFFSETS);
+    view.dest = section<uint32_t>(DEST);
+    view.weight = section<float>(WEIGHT);
+    view.vertices = header->numVertices;
+    view.edges = header->numEdges;
+    return view;
+}
+
+CsrView GraphSnapshot::getReverseCsr() const {
+    CsrView view;
+    view.offsets = section<uint32_t>(REVERSE_OFFSETS);
+    view.dest = section<uint32_t>(REVERSE_DEST);
+    view.weight = section<float>(REVERSE_WEIGHT);
+    view.vertices = header->numVertices;
+    view.edges = header->numEdges;
+    return view;
+}
+
+size_t GraphSnapshot::numPointsOfInterest() const {
+    return header->numPointsOfInterest;
+}
+
+/**
+ * @return  index of the vertex of the i-th point of interest
+ */
+uint32_t GraphSnapshot::getPointOfInterest(size_t i) const {
+    return section<uint32_t>(POI_VERTICES)[i];
+}
+
+POICategory GraphSnapshot::getCategory(size_t i) const {
+    return static_cast<POICategory>(section<uint32_t>(POI_CATEGORIES)[i]);
+}
+
+bool GraphSnapshot::hasRows() const {
+    return header->numRows > 0;
+}
+
+/**
+ * @brief Adds the vertices and edges of the snapshot to an empty graph, with the stored weights, and fills the points
+ * of interest and their categories.
+ */
+void GraphSnapshot::toGraph(Graph<PosInfo>& graph, std::vector<Vertex<PosInfo>*>& pointsOfInterest,
+                            std::vector<POICategory>& categories) const {
+    const uint32_t n = header->numVertices;
+    const uint32_t* ids = section<uint32_t>(IDS);
+    const float* x = section<float>(X);
+    const float* y = section<float>(Y);
+    const CsrView csr = getCsr();
+
+    graph.reserveVertices(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        graph.addVertex(PosInfo(ids[v], x[v], y[v]));
+    }
+
+    std::vector<size_t> outDegrees(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        outDegrees[v] = csr.edgesEnd(v) - csr.edgesBegin(v);
+    }
+    graph.reserveEdges(outDegrees);
+
+    for (uint32_t v = 0; v < n; ++v) {
+        Vertex<PosInfo>* source = graph.getVertex(v);
+        for (uint32_t e = csr.edgesBegin(v); e < csr.edgesEnd(v); ++e) {
+            graph.addEdge(source, graph.getVertex(csr.dest[e]), csr.weight[e]);
+        }
+    }
+
+    for (size_t i = 0; i < header->numPointsOfInterest; ++i) {
+        pointsOfInterest.push_back(graph.getVertex(getPointOfInterest(i)));
+        categories.push_back(getCategory(i));
+    }
+}
+
+/**
+ * @brief Copies the distance rows of the snapshot, if it has any, into a cache, replacing its previous contents. Rows
+ * which link to vertices out of range leave the cache empty, so that it is built again.
+ */
+void GraphSnapshot::toCache(DistanceRowCache& cache) const {
+    if (!hasRows())
+        return;
+
+    const uint32_t n = header->numVertices;
+    const uint32_t r = header->numRows;
+    const uint32_t* rowSources = section<uint32_t>(ROW_SOURCES);
+
+    cache.sources.assign(rowSources, rowSources + r);
+    cache.numVertices = n;
+    cache.numEdges = header->numEdges;
+    cache.fingerprint = header->rowsFingerprint;
+
+    cache.rowOfVertex.assign(n, DistanceRowCache::NO_ROW);
+    for (uint32_t row = 0; row < r; ++row) {
+        cache.rowOfVertex[rowSources[row]] = row;
+    }
+
+    auto copyRows = [n, r](const auto* rows, auto& matrix) {
+        for (uint32_t row = 0; row < r; ++row) {
+            std::copy(rows + static_cast<size_t>(row) * n, rows + static_cast<size_t>(row + 1) * n, matrix[row]);
+        }
+    };
+
+    cache.forwardDistances = FlatMatrix<float>(r, n, 0);
+    cache.forwardPred = FlatMatrix<uint32_t>(r, n, 0);
+    cache.reverseDistances = FlatMatrix<float>(r, n, 0);
+    cache.reverseSucc = FlatMatrix<uint32_t>(r, n, 0);
+    copyRows(section<float>(FORWARD_DISTANCES), cache.forwardDistances);
+    copyRows(section<uint32_t>(FORWARD_PRED), cache.forwardPred);
+    copyRows(section<float>(REVERSE_DISTANCES), cache.reverseDistances);
+    copyRows(section<uint32_t>(REVERSE_SUCC), cache.reverseSucc);
+
+    if (!isValidTree(cache.forwardPred, n) || !isValidTree(cache.reverseSucc, n)) {
+        cache = DistanceRowCache();
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef GRAPH_SNAPSHOT_H
+#define GRAPH_SNAPSHOT_H
+
+#include "CsrGraph.h"
+#include "DistanceRowCache.h"
+#include "MappedFile.h"
+#include "parsing.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Binary snapshot of a map: its vertices with their coordinates, the forward and reverse CSR arrays with the edge
+ * weights already computed, the points of interest with their categories and, optionally, the distance rows of the
+ * points of interest (see DistanceRowCache).
+ *
+ * The file is a fixed header followed by one section per array, each starting on a cache line boundary, in the byte
+ * order of the machine that wrote it. Loading maps the file and checks the header and the structure of the CSR arrays,
+ * with a single pass over them; the arrays are then read straight from the mapped pages, without being copied.
+ * getCsr() and getReverseCsr() are views of those pages, on which the searches templated on the graph type run
+ * directly, and toGraph() builds a Graph without parsing any text nor computing any edge weight.
+ */
+class GraphSnapshot {
+public:
+    GraphSnapshot() = default;
+
+    static bool write(const std::string& path, Graph<PosInfo>& graph,
+                      const std::vector<Vertex<PosInfo>*>& pointsOfInterest, const std::vector<POICategory>& categories,
+                      uint64_t sourceStamp = 0, const DistanceRowCache* rows = nullptr);
+    bool load(const std::string& path);
+
+    uint64_t getSourceStamp() const;
+    uint32_t numVertices() const;
+    uint32_t numEdges() const;
+    unsigned int getId(uint32_t v) const;
+    float getX(uint32_t v) const;
+    float getY(uint32_t v) const;
+    CsrView getCsr() const;
+    CsrView getReverseCsr() const;
+
+    size_t numPointsOfInterest() const;
+    uint32_t getPointOfInterest(size_t i) const;
+    POICategory getCategory(size_t i) const;
+    bool hasRows() const;
+
+    void toGraph(Graph<PosInfo>& graph, std::vector<Vertex<PosInfo>*>& pointsOfInterest,
+                 std::vector<POICategory>& categories) const;
+    void toCache(DistanceRowCache& cache) const;
+private:
+    enum Section {
+        IDS,
+        X,
+        Y,
+        OFFSETS,
+        DEST,
+        WEIGHT,
+        REVERSE_OFFSETS,
+        REVERSE_DEST,
+        REVERSE_WEIGHT,
+        POI_VERTICES,
+        POI_CATEGORIES,
+        ROW_SOURCES,
+        FORWARD_DISTANCES,
+        FORWARD_PRED,
+        REVERSE_DISTANCES,
+        REVERSE_SUCC,
+        NUM_SECTIONS
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        // Value given by the writer to identify what the snapshot was made from (e.g. the text files of the map)
+        uint64_t sourceStamp;
+        // Fingerprint of the graph the distance rows were computed on (see DistanceRowCache::matches)
+        uint64_t rowsFingerprint;
+        uint32_t numVertices;
+        uint32_t numEdges;
+        uint32_t numPointsOfInterest;
+        // Number of distance rows (0 if the snapshot has none)
+        uint32_t numRows;
+        // Position of each section in the file, in bytes
+        uint64_t sectionOffsets[NUM_SECTIONS];
+    };
+
+    std::unique_ptr<MappedFile> file;
+    const Header* header = nullptr;
+
+    static void sectionSizes(const Header& header, uint64_t sizes[NUM_SECTIONS]);
+
+    template<class E>
+    const E* section(Section s) const;
+};
+
+template<class E>
+const E* GraphSnapshot::section(Section s) const {
+    return reinterpret_cast<const E*>(file->data() + header->sectionOffsets[s]);
+}
+
+#endif // GRAPH_SNAPSHOT_H
@@ -0,0 +1,299 @@
+#ifndef HEAP_POLICIES_H
+#define HEAP_POLICIES_H
+
+#include "IndexedPriorityQueue.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/*
+ * Priority queue policies for Dijkstra's algorithm, all with the interface of IndexedPriorityQueue (elements are dense
+ * indices whose keys live in an external array), so any of them can be passed to dijkstraOverCsr, Graph::dijkstra or
+ * Graph::dijkstraShortestPath. See also RadixHeap and DialQueue, which rely on keys being extracted in order.
+ */
+
+template <class Key>
+using BinaryHeap = IndexedPriorityQueue<Key, 2>;
+
+template <class Key>
+using FourAryHeap = IndexedPriorityQueue<Key, 4>;
+
+template <class Key>
+using EightAryHeap = IndexedPriorityQueue<Key, 8>;
+
+/**
+ * Pairing heap: a tree where every node has a key no smaller than its parent, stored as arrays of links indexed by
+ * element. insert and decreaseKey are constant time (the element's subtree is linked to the root), and extractMin
+ * pairs the children of the root in two passes, taking amortised logarithmic time.
+ */
+template <class Key>
+class PairingHeap {
+public:
+    PairingHeap() = default;
+
+    void reset(const Key* keys, uint32_t numElements);
+    bool empty() const;
+    bool contains(uint32_t v) const;
+
+    void insert(uint32_t v);
+    uint32_t extractMin();
+    void decreaseKey(uint32_t v);
+    void clear();
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // First child, next sibling and previous sibling (or parent, for a first child) of each element
+    std::vector<uint32_t> child, next, prev;
+    std::vector<uint8_t> queued;
+    // Reused by clear and mergePairs
+    std::vector<uint32_t> scratch;
+    const Key* keys = nullptr;
+    uint32_t root = NONE;
+
+    uint32_t link(uint32_t a, uint32_t b);
+    uint32_t mergePairs(uint32_t first);
+};
+
+template <class Key>
+constexpr uint32_t PairingHeap<Key>::NONE;
+
+/**
+ * @brief Prepares the queue for a new search
+ * @param keys          array with the key of every element, read on every comparison
+ * @param numElements   number of elements that may be inserted (elements are indices in [0, numElements))
+ */
+template <class Key>
+void PairingHeap<Key>::reset(const Key* keys, uint32_t numElements) {
+    this->keys = keys;
+    clear();
+    if (queued.size() != numElements) {
+        child.assign(numElements, NONE);
+        next.assign(numElements, NONE);
+        prev.assign(numElements, NONE);
+        queued.assign(numElements, 0);
+    }
+}
+
+template <class Key>
+bool PairingHeap<Key>::empty() const {
+    return root == NONE;
+}
+
+template <class Key>
+bool PairingHeap<Key>::contains(uint32_t v) const {
+    return queued[v];
+}
+
+template <class Key>
+void PairingHeap<Key>::insert(uint32_t v) {
+    queued[v] = 1;
+    root = root == NONE ? v : link(root, v);
+}
+
+template <class Key>
+uint32_t PairingHeap<Key>::extractMin() {
+    uint32_t v = root;
+    root = mergePairs(child[v]);
+    if (root != NONE) {
+        prev[root] = NONE;
+    }
+
+    child[v] = NONE;
+    queued[v] = 0;
+    return v;
+}
+
+/**
+ * @brief Cuts the subtree of an element whose key decreased and links it to the root.
+ */
+template <class Key>
+void PairingHeap<Key>::decreaseKey(uint32_t v) {
+    if (v == root)
+        return;
+
+    if (child[prev[v]] == v) {
+        child[prev[v]] = next[v];
+    }
+    else {
+        next[prev[v]] = next[v];
+    }
+    if (next[v] != NONE) {
+        prev[next[v]] = prev[v];
+    }
+    next[v] = NONE;
+    prev[v] = NONE;
+
+    root = link(root, v);
+}
+
+/**
+ * @brief Removes every element from the queue, in time proportional to the number of queued elements.
+ */
+template <class Key>
+void PairingHeap<Key>::clear() {
+    std::vector<uint32_t>& stack = scratch;
+    stack.clear();
+    if (root != NONE) {
+        stack.push_back(root);
+    }
+
+    while (!stack.empty()) {
+        uint32_t v = stack.back();
+        stack.pop_back();
+
+        for (uint32_t c = child[v]; c != NONE; c = next[c]) {
+            stack.push_back(c);
+        }
+        child[v] = next[v] = prev[v] = NONE;
+        queued[v] = 0;
+    }
+    root = NONE;
+}
+
+/**
+ * @brief Links two trees (roots without siblings), making the one with the larger key the first child of the other.
+ * @return  root of the resulting tree
+ */
+template <class Key>
+uint32_t PairingHeap<Key>::link(uint32_t a, uint32_t b) {
+    if (keys[b] < keys[a]) {
+        std::swap(a, b);
+    }
+
+    next[b] = child[a];
+    if (child[a] != NONE) {
+        prev[child[a]] = b;
+    }
+    prev[b] = a;
+    child[a] = b;
+    return a;
+}
+
+/**
+ * @brief Merges a list of siblings into a single tree: first links them in pairs from left to right, and then links
+ * the resulting trees from right to left.
+ * @return  root of the resulting tree (NONE if the list is empty)
+ */
+template <class Key>
+uint32_t PairingHeap<Key>::mergePairs(uint32_t first) {
+    std::vector<uint32_t>& pairs = scratch;
+    pairs.clear();
+
+    while (first != NONE) {
+        uint32_t a = first;
+        uint32_t b = next[a];
+        if (b == NONE) {
+            next[a] = prev[a] = NONE;
+            pairs.push_back(a);
+            break;
+        }
+
+        first = next[b];
+        next[a] = prev[a] = next[b] = prev[b] = NONE;
+        pairs.push_back(link(a, b));
+    }
+
+    uint32_t result = NONE;
+    for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) {
+        result = result == NONE ? *it : link(*it, result);
+    }
+    return result;
+}
+
+
+/**
+ * Binary heap without decreaseKey: decreasing the key of an element pushes a new entry with a copy of the key, and the
+ * outdated entries are skipped when they reach the top. The heap holds more entries than elements, but entries are
+ * moved without writing to a position array, and their keys are compared without reading the key array.
+ */
+template <class Key>
+class LazyBinaryHeap {
+public:
+    LazyBinaryHeap() = default;
+
+    void reset(const Key* keys, uint32_t numElements);
+    bool empty() const;
+    bool contains(uint32_t v) const;
+
+    void insert(uint32_t v);
+    uint32_t extractMin();
+    void decreaseKey(uint32_t v);
+    void clear();
+private:
+    // Entries (key, element), possibly outdated
+    std::vector<std::pair<Key, uint32_t>> heap;
+    std::vector<uint8_t> queued;
+    const Key* keys = nullptr;
+    uint32_t size = 0;
+
+    void push(uint32_t v);
+};
+
+template <class Key>
+void LazyBinaryHeap<Key>::reset(const Key* keys, uint32_t numElements) {
+    this->keys = keys;
+    clear();
+    if (queued.size() != numElements) {
+        queued.assign(numElements, 0);
+    }
+}
+
+template <class Key>
+bool LazyBinaryHeap<Key>::empty() const {
+    return size == 0;
+}
+
+template <class Key>
+bool LazyBinaryHeap<Key>::contains(uint32_t v) const {
+    return queued[v];
+}
+
+template <class Key>
+void LazyBinaryHeap<Key>::insert(uint32_t v) {
+    queued[v] = 1;
+    ++size;
+    push(v);
+}
+
+template <class Key>
+uint32_t LazyBinaryHeap<Key>::extractMin() {
+    while (true) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<Key, uint32_t>>());
+        std::pair<Key, uint32_t> entry = heap.back();
+        heap.pop_back();
+
+        if (queued[entry.second] && entry.first == keys[entry.second]) {
+            queued[entry.second] = 0;
+            --size;
+            return entry.second;
+        }
+    }
+}
+
+template <class Key>
+void LazyBinaryHeap<Key>::decreaseKey(uint32_t v) {
+    push(v);
+}
+
+/**
+ * @brief Removes every element from the queue, in time proportional to the number of entries.
+ */
+template <class Key>
+void LazyBinaryHeap<Key>::clear() {
+    for (const std::pair<Key, uint32_t>& entry : heap) {
+        queued[entry.second] = 0;
+    }
+    heap.clear();
+    size = 0;
+}
+
+template <class Key>
+void LazyBinaryHeap<Key>::push(uint32_t v) {
+    heap.push_back({keys[v], v});
+    std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<Key, uint32_t>>());
+}
+
+#endif // HEAP_POLICIES_H
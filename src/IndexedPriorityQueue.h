@@ -0,0 +1,151 @@
+#ifndef INDEXED_PRIORITY_QUEUE_H
+#define INDEXED_PRIORITY_QUEUE_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Mutable d-ary min-heap over dense vertex indices. Elements are plain indices and their keys live in an external
+ * array (typically the distance array of a search), so comparisons read two keys instead of dereferencing two vertex
+ * objects.
+ *
+ * Wider heaps (Arity 4 or 8) are shallower, so decreaseKey moves elements fewer levels up, and the children of a node
+ * share a cache line, at the cost of more comparisons in extractMin.
+ */
+template <class Key, unsigned Arity = 2>
+class IndexedPriorityQueue {
+public:
+    static constexpr uint32_t NOT_IN_QUEUE = UINT32_MAX;
+
+    IndexedPriorityQueue() = default;
+
+    void reset(const Key* keys, uint32_t numElements);
+    bool empty() const;
+    bool contains(uint32_t v) const;
+
+    void insert(uint32_t v);
+    uint32_t top() const;
+    uint32_t extractMin();
+    void decreaseKey(uint32_t v);
+    void clear();
+private:
+    std::vector<uint32_t> heap;
+    std::vector<uint32_t> position;
+    const Key* keys = nullptr;
+
+    void heapifyUp(uint32_t i);
+    void heapifyDown(uint32_t i);
+    void set(uint32_t i, uint32_t v);
+};
+
+template <class Key, unsigned Arity>
+constexpr uint32_t IndexedPriorityQueue<Key, Arity>::NOT_IN_QUEUE;
+
+/**
+ * @brief Prepares the queue for a new search
+ * @param keys          array with the key of every element, read on every comparison
+ * @param numElements   number of elements that may be inserted (elements are indices in [0, numElements))
+ */
+template <class Key, unsigned Arity>
+void IndexedPriorityQueue<Key, Arity>::reset(const Key* keys, uint32_t numElements) {
+    this->keys = keys;
+    clear();
+    if (position.size() != numElements) {
+        position.assign(numElements, NOT_IN_QUEUE);
+    }
+}
+
+template <class Key, unsigned Arity>
+bool IndexedPriorityQueue<Key, Arity>::empty() const {
+    return heap.empty();
+}
+
+template <class Key, unsigned Arity>
+bool IndexedPriorityQueue<Key, Arity>::contains(uint32_t v) const {
+    return position[v] != NOT_IN_QUEUE;
+}
+
+template <class Key, unsigned Arity>
+void IndexedPriorityQueue<Key, Arity>::insert(uint32_t v) {
+    heap.push_back(v);
+    heapifyUp(heap.size() - 1);
+}
+
+/**
+ * @brief Returns the element with the minimum key, without removing it. The queue must not be empty.
+ */
+template <class Key, unsigned Arity>
+uint32_t IndexedPriorityQueue<Key, Arity>::top() const {
+    return heap[0];
+}
+
+template <class Key, unsigned Arity>
+uint32_t IndexedPriorityQueue<Key, Arity>::extractMin() {
+    uint32_t v = heap[0];
+    heap[0] = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        heapifyDown(0);
+    }
+    position[v] = NOT_IN_QUEUE;
+    return v;
+}
+
+template <class Key, unsigned Arity>
+void IndexedPriorityQueue<Key, Arity>::decreaseKey(uint32_t v) {
+    heapifyUp(position[v]);
+}
+
+/**
+ * @brief Removes every element from the queue, in time proportional to the number of queued elements.
+ */
+template <class Key, unsigned Arity>
+void IndexedPriorityQueue<Key, Arity>::clear() {
+    for (uint32_t v : heap) {
+        position[v] = NOT_IN_QUEUE;
+    }
+    heap.clear();
+}
+
+template <class Key, unsigned Arity>
+void IndexedPriorityQueue<Key, Arity>::heapifyUp(uint32_t i) {
+    uint32_t v = heap[i];
+    while (i > 0 && keys[v] < keys[heap[(i - 1) / Arity]]) {
+        set(i, heap[(i - 1) / Arity]);
+        i = (i - 1) / Arity;
+    }
+    set(i, v);
+}
+
+template <class Key, unsigned Arity>
+void IndexedPriorityQueue<Key, Arity>::heapifyDown(uint32_t i) {
+    uint32_t v = heap[i];
+    uint32_t size = heap.size();
+    while (true) {
+        uint32_t first = Arity * i + 1;
+        if (first >= size)
+            break;
+
+        // Smallest child of i
+        uint32_t k = first;
+        uint32_t last = first + Arity < size ? first + Arity : size;
+        for (uint32_t child = first + 1; child < last; ++child) {
+            if (keys[heap[child]] < keys[heap[k]])
+                k = child;
+        }
+
+        if (!(keys[heap[k]] < keys[v]))
+            break;
+        set(i, heap[k]);
+        i = k;
+    }
+    set(i, v);
+}
+
+template <class Key, unsigned Arity>
+void IndexedPriorityQueue<Key, Arity>::set(uint32_t i, uint32_t v) {
+    heap[i] = v;
+    position[v] = i;
+}
+
+#endif // INDEXED_PRIORITY_QUEUE_H
@@ -0,0 +1,198 @@
+#include "Landmarks.h"
+#include "SearchWorkspace.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+static const float INF = std::numeric_limits<float>::max();
+
+/**
+ * @brief Chooses the landmarks and computes their distances to and from every vertex, with two Dijkstra searches per
+ * landmark (plus one per landmark to find it, when chosen with AVOID).
+ * @param graph         graph to preprocess
+ * @param reverse       reverse of the graph
+ * @param numLandmarks  number of landmarks (fewer if the graph has fewer vertices)
+ * @param selection     how the landmarks are chosen
+ */
+Landmarks::Landmarks(const CsrGraph& graph, const CsrGraph& reverse, unsigned numLandmarks,
+                     LandmarkSelection selection) :
+        numVertices(graph.numVertices()), numEdges(graph.numEdges()), fingerprint(graph.fingerprint()) {
+    const uint32_t n = graph.numVertices();
+    const size_t count = std::min<size_t>(numLandmarks, n);
+    fromLandmark = FlatMatrix<float>(n, count, INF);
+    toLandmark = FlatMatrix<float>(n, count, INF);
+
+    // Fixed seed, so the same graph always gets the same landmarks
+    std::minstd_rand random(1);
+    std::uniform_int_distribution<uint32_t> randomVertex(0, n == 0 ? 0 : n - 1);
+
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t landmark = NO_VERTEX;
+        if (selection == AVOID) {
+            landmark = avoidVertex(graph, randomVertex(random));
+        }
+        // The farthest vertex is also used when every subtree of the random root already has a landmark
+        if (landmark == NO_VERTEX) {
+            landmark = k == 0 ? randomVertex(random) : farthestVertex();
+        }
+        addLandmark(landmark, graph, reverse, k);
+    }
+}
+
+size_t Landmarks::size() const {
+    return landmarks.size();
+}
+
+uint32_t Landmarks::getLandmark(size_t k) const {
+    return landmarks[k];
+}
+
+/**
+ * @brief Checks if the landmarks may have been chosen on a graph (i.e. it has the same size and fingerprint). Updating
+ * or removing any edge may make the bounds inadmissible, so the landmarks must be chosen again. The fingerprint is the
+ * one kept by the graph, so the check takes constant time and can guard every query.
+ */
+bool Landmarks::matches(const CsrGraph& graph) const {
+    return numVertices == graph.numVertices() && numEdges == graph.numEdges() && fingerprint == graph.fingerprint();
+}
+
+/**
+ * @brief Calculates a lower bound of the distance between two vertices, from the triangle inequalities of every
+ * landmark. The bound is MAX_FLOAT if the landmarks prove that the target cannot be reached (e.g. a landmark reaches
+ * the source but not the target).
+ */
+float Landmarks::lowerBound(uint32_t from, uint32_t to) const {
+    const float* fromSource = fromLandmark[from];
+    const float* fromTarget = fromLandmark[to];
+    const float* toSource = toLandmark[from];
+    const float* toTarget = toLandmark[to];
+
+    float bound = 0;
+    for (size_t k = 0; k < landmarks.size(); ++k) {
+        if (fromSource[k] != INF) {
+            if (fromTarget[k] == INF)
+                return INF;
+            bound = std::max(bound, fromTarget[k] - fromSource[k]);
+        }
+        if (toTarget[k] != INF) {
+            if (toSource[k] == INF)
+                return INF;
+            bound = std::max(bound, toSource[k] - toTarget[k]);
+        }
+    }
+    return bound;
+}
+
+/**
+ * @brief Stores the distances from and to a new landmark in a column of the matrices.
+ */
+void Landmarks::addLandmark(uint32_t landmark, const CsrGraph& graph, const CsrGraph& reverse, size_t column) {
+    SearchWorkspace workspace;
+
+    dijkstraOverCsr(graph, landmark, workspace);
+    for (uint32_t v : workspace.reachedVertices) {
+        fromLandmark[v][column] = workspace.getDist(v);
+    }
+
+    dijkstraOverCsr(reverse, landmark, workspace);
+    for (uint32_t v : workspace.reachedVertices) {
+        toLandmark[v][column] = workspace.getDist(v);
+    }
+
+    landmarks.push_back(landmark);
+}
+
+/**
+ * @brief Finds the vertex furthest from the landmarks already chosen (the one whose distance from its closest landmark
+ * is largest). Vertices no landmark reaches come first, so every part of the graph eventually gets a landmark.
+ */
+uint32_t Landmarks::farthestVertex() const {
+    uint32_t farthest = 0;
+    float farthestDist = -1;
+
+    for (uint32_t v = 0; v < numVertices; ++v) {
+        float dist = INF;
+        for (size_t k = 0; k < landmarks.size(); ++k) {
+            dist = std::min(dist, fromLandmark[v][k]);
+        }
+        if (dist > farthestDist) {
+            farthest = v;
+            farthestDist = dist;
+        }
+    }
+    return farthest;
+}
+
+/**
+ * @brief Chooses a landmark with the avoid heuristic: in the shortest path tree of a root, each vertex is weighted by
+ * how much the current bounds underestimate its distance from the root, and the new landmark is found by descending
+ * from the root into the heaviest subtree until reaching a leaf. Subtrees which already have a landmark weigh nothing.
+ * @return  the new landmark, or NO_VERTEX if every subtree of the root has a landmark
+ */
+uint32_t Landmarks::avoidVertex(const CsrGraph& graph, uint32_t root) const {
+    SearchWorkspace workspace;
+    dijkstraOverCsr(graph, root, workspace);
+    const std::vector<uint32_t>& reached = workspace.reachedVertices;
+
+    // Children of each vertex of the tree, grouped by parent with a counting sort
+    std::vector<uint32_t> childOffsets(numVertices + 1, 0);
+    for (uint32_t v : reached) {
+        if (v != root) {
+            ++childOffsets[workspace.getPred(v) + 1];
+        }
+    }
+    for (uint32_t v = 0; v < numVertices; ++v) {
+        childOffsets[v + 1] += childOffsets[v];
+    }
+    std::vector<uint32_t> children(childOffsets[numVertices]);
+    std::vector<uint32_t> next(childOffsets.begin(), childOffsets.end() - 1);
+    for (uint32_t v : reached) {
+        if (v != root) {
+            children[next[workspace.getPred(v)]++] = v;
+        }
+    }
+
+    // Breadth-first order, where every vertex comes after its parent
+    std::vector<uint32_t> order = {root};
+    for (size_t i = 0; i < order.size(); ++i) {
+        uint32_t v = order[i];
+        order.insert(order.end(), children.begin() + childOffsets[v], children.begin() + childOffsets[v + 1]);
+    }
+
+    std::vector<uint8_t> isLandmark(numVertices, 0);
+    for (uint32_t landmark : landmarks) {
+        isLandmark[landmark] = 1;
+    }
+
+    std::vector<double> weight(numVertices, 0);
+    std::vector<uint8_t> covered(numVertices, 0);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        uint32_t v = *it;
+        covered[v] = isLandmark[v];
+        weight[v] = workspace.getDist(v) - std::min(lowerBound(root, v), workspace.getDist(v));
+
+        for (uint32_t c = childOffsets[v]; c < childOffsets[v + 1]; ++c) {
+            covered[v] |= covered[children[c]];
+            weight[v] += weight[children[c]];
+        }
+        if (covered[v]) {
+            weight[v] = 0;
+        }
+    }
+
+    uint32_t v = root;
+    while (true) {
+        uint32_t heaviest = NO_VERTEX;
+        for (uint32_t c = childOffsets[v]; c < childOffsets[v + 1]; ++c) {
+            if (weight[children[c]] > 0 && (heaviest == NO_VERTEX || weight[children[c]] > weight[heaviest])) {
+                heaviest = children[c];
+            }
+        }
+        if (heaviest == NO_VERTEX)
+            break;
+        v = heaviest;
+    }
+
+    return v == root || covered[v] ? NO_VERTEX : v;
+}
@@ -0,0 +1,58 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "CsrGraph.h"
+#include "FlatMatrix.h"
+
+#include <cstdint>
+#include <vector>
+
+enum LandmarkSelection {
+    // Each landmark is the vertex furthest from the landmarks already chosen
+    FARTHEST,
+    // Each landmark is the leaf of the shortest path tree of a random root below which the current lower bounds are
+    // worst, avoiding the parts of the graph already covered by landmarks
+    AVOID
+};
+
+/**
+ * Landmarks for the ALT (A*, landmarks and triangle inequality) lower bounds of shortest path distances.
+ *
+ * Preprocessing chooses a few landmark vertices and stores the distances from each landmark to every vertex and from
+ * every vertex to each landmark. By the triangle inequality, for any landmark L, d(v, t) >= d(L, t) - d(L, v) and
+ * d(v, t) >= d(v, L) - d(t, L), so the best of these over all landmarks is a lower bound of the distance between any two
+ * vertices, computed in time linear in the number of landmarks. Unlike straight-line distances, these bounds hold
+ * whatever the edge weights mean, and are usually much tighter.
+ *
+ * Vertices are identified by the same dense indices as in the CSR graph the landmarks were chosen on.
+ */
+class Landmarks {
+public:
+    Landmarks() = default;
+    Landmarks(const CsrGraph& graph, const CsrGraph& reverse, unsigned numLandmarks,
+              LandmarkSelection selection = AVOID);
+
+    size_t size() const;
+    uint32_t getLandmark(size_t k) const;
+    bool matches(const CsrGraph& graph) const;
+
+    float lowerBound(uint32_t from, uint32_t to) const;
+private:
+    std::vector<uint32_t> landmarks;
+
+    // Row v of each matrix belongs to vertex v, and column k to the k-th landmark, so the bounds of a pair of vertices
+    // read two short rows
+    FlatMatrix<float> fromLandmark;
+    FlatMatrix<float> toLandmark;
+
+    // Size and fingerprint of the graph the landmarks were chosen on, used to detect stale landmarks
+    uint32_t numVertices = 0;
+    uint32_t numEdges = 0;
+    uint64_t fingerprint = 0;
+
+    void addLandmark(uint32_t landmark, const CsrGraph& graph, const CsrGraph& reverse, size_t column);
+    uint32_t farthestVertex() const;
+    uint32_t avoidVertex(const CsrGraph& graph, uint32_t root) const;
+};
+
+#endif // LANDMARKS_H
@@ -0,0 +1,74 @@
+#include "MappedFile.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+/**
+ * @brief Opens a file and maps its contents. If it cannot be opened, the view is empty and isOpen() is false.
+ */
+MappedFile::MappedFile(const std::string& path) {
+#if defined(__linux__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat status;
+    if (fstat(fd, &status) == 0) {
+        length = static_cast<size_t>(status.st_size);
+        open = true;
+
+        if (length > 0) {
+            void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                length = 0;
+                open = false;
+            }
+            else {
+                // Files are mostly scanned from start to end, so the kernel can read ahead aggressively
+                madvise(mapping, length, MADV_SEQUENTIAL);
+                contents = static_cast<const char*>(mapping);
+                mapped = true;
+            }
+        }
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+#else
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open())
+        return;
+
+    buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    contents = buffer.data();
+    length = buffer.size();
+    open = true;
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if defined(__linux__) || defined(__APPLE__)
+    if (mapped) {
+        munmap(const_cast<char*>(contents), length);
+    }
+#endif
+}
+
+bool MappedFile::isOpen() const {
+    return open;
+}
+
+const char* MappedFile::data() const {
+    return contents;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
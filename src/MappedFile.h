@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only view of the whole contents of a file. On Linux and macOS the file is memory-mapped, so opening it costs
+ * nothing up front and its pages are read (and shared with the page cache) only as they are touched. Elsewhere it is
+ * read into memory once.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const;
+    const char* data() const;
+    size_t size() const;
+private:
+    const char* contents = nullptr;
+    size_t length = 0;
+    bool open = false;
+
+#if defined(__linux__) || defined(__APPLE__)
+    // Whether contents points to a mapping, which empty files do not have
+    bool mapped = false;
+#else
+    std::vector<char> buffer;
+#endif
+};
+
+#endif // MAPPED_FILE_H
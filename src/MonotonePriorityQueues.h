@@ -0,0 +1,378 @@
+#ifndef MONOTONE_PRIORITY_QUEUES_H
+#define MONOTONE_PRIORITY_QUEUES_H
+
+#include "CsrGraph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Priority queues for Dijkstra's algorithm which rely on its extractions being monotone: no key inserted is smaller than
+ * the last key extracted. They have the same interface as IndexedPriorityQueue<Key> (keys live in an external array),
+ * but decreaseKey adds a new entry instead of moving the old one, which is recognised as outdated and skipped when it
+ * is reached.
+ */
+
+/**
+ * Radix heap over the bit patterns of the keys. The bit patterns of non-negative floats (and doubles) are ordered like
+ * the numbers themselves, as are those of unsigned integers, so the keys are compared exactly, without quantising them.
+ *
+ * Bucket 0 holds the entries whose key is equal to the last extracted key, and bucket i > 0 those whose key first
+ * differs from it in bit i - 1 (counting from the least significant one). Extracting from an empty bucket 0 moves the
+ * entries of the first non-empty bucket to lower buckets, so each entry is moved at most once per bit of the keys.
+ */
+template <class Key>
+class RadixHeap {
+public:
+    RadixHeap() = default;
+
+    void reset(const Key* keys, uint32_t numElements);
+    bool empty() const;
+    bool contains(uint32_t v) const;
+
+    void insert(uint32_t v);
+    uint32_t extractMin();
+    void decreaseKey(uint32_t v);
+    void clear();
+private:
+    // Unsigned integer with the bits of a key
+    using Bits = typename std::conditional<sizeof(Key) <= sizeof(uint32_t), uint32_t, uint64_t>::type;
+    static const unsigned NUM_BITS = 8 * sizeof(Bits);
+    static const unsigned NUM_BUCKETS = NUM_BITS + 1;
+
+    // Entries (key bits, element), possibly outdated
+    std::vector<std::pair<Bits, uint32_t>> buckets[NUM_BUCKETS];
+    std::vector<uint8_t> queued;
+    const Key* keys = nullptr;
+    Bits last = 0;
+    uint32_t size = 0;
+
+    static Bits keyBits(Key key);
+    unsigned bucketIndex(Bits bits) const;
+    bool isCurrent(const std::pair<Bits, uint32_t>& entry) const;
+    void push(uint32_t v);
+    bool refillFirstBucket();
+};
+
+/**
+ * @brief Prepares the queue for a new search
+ * @param keys          array with the key of every element (non-negative), read when elements are inserted
+ * @param numElements   number of elements that may be inserted (elements are indices in [0, numElements))
+ */
+template <class Key>
+inline void RadixHeap<Key>::reset(const Key* keys, uint32_t numElements) {
+    this->keys = keys;
+    clear();
+    if (queued.size() != numElements) {
+        queued.assign(numElements, 0);
+    }
+}
+
+template <class Key>
+inline bool RadixHeap<Key>::empty() const {
+    return size == 0;
+}
+
+template <class Key>
+inline bool RadixHeap<Key>::contains(uint32_t v) const {
+    return queued[v];
+}
+
+template <class Key>
+inline void RadixHeap<Key>::insert(uint32_t v) {
+    queued[v] = 1;
+    ++size;
+    push(v);
+}
+
+template <class Key>
+inline void RadixHeap<Key>::decreaseKey(uint32_t v) {
+    push(v);
+}
+
+/**
+ * @brief Removes and returns the element with the minimum key. The queue must not be empty.
+ */
+template <class Key>
+inline uint32_t RadixHeap<Key>::extractMin() {
+    while (true) {
+        if (buckets[0].empty()) {
+            refillFirstBucket();
+        }
+
+        std::pair<Bits, uint32_t> entry = buckets[0].back();
+        buckets[0].pop_back();
+
+        if (isCurrent(entry)) {
+            queued[entry.second] = 0;
+            --size;
+            return entry.second;
+        }
+    }
+}
+
+/**
+ * @brief Removes every element from the queue, in time proportional to the number of entries.
+ */
+template <class Key>
+inline void RadixHeap<Key>::clear() {
+    for (std::vector<std::pair<Bits, uint32_t>>& bucket : buckets) {
+        for (const std::pair<Bits, uint32_t>& entry : bucket) {
+            queued[entry.second] = 0;
+        }
+        bucket.clear();
+    }
+    last = 0;
+    size = 0;
+}
+
+template <class Key>
+inline typename RadixHeap<Key>::Bits RadixHeap<Key>::keyBits(Key key) {
+    Bits bits = 0;
+    std::memcpy(&bits, &key, sizeof(Key));
+    return bits;
+}
+
+template <class Key>
+inline unsigned RadixHeap<Key>::bucketIndex(Bits bits) const {
+    Bits difference = bits ^ last;
+    if (difference == 0)
+        return 0;
+    return NUM_BITS == 32 ? 32 - __builtin_clz(static_cast<uint32_t>(difference)) :
+            64 - __builtin_clzll(static_cast<uint64_t>(difference));
+}
+
+/**
+ * @brief Checks if an entry is the one with the current key of its element, and not an outdated one.
+ */
+template <class Key>
+inline bool RadixHeap<Key>::isCurrent(const std::pair<Bits, uint32_t>& entry) const {
+    return queued[entry.second] && entry.first == keyBits(keys[entry.second]);
+}
+
+template <class Key>
+inline void RadixHeap<Key>::push(uint32_t v) {
+    Bits bits = keyBits(keys[v]);
+    buckets[bucketIndex(bits)].push_back({bits, v});
+}
+
+/**
+ * @brief Moves the entries with the minimum key to bucket 0, making it the new last key. Outdated entries found along
+ * the way are dropped.
+ */
+template <class Key>
+inline bool RadixHeap<Key>::refillFirstBucket() {
+    for (unsigned i = 1; i < NUM_BUCKETS; ++i) {
+        std::vector<std::pair<Bits, uint32_t>>& bucket = buckets[i];
+
+        bool found = false;
+        Bits minBits = 0;
+        for (const std::pair<Bits, uint32_t>& entry : bucket) {
+            if (isCurrent(entry) && (!found || entry.first < minBits)) {
+                minBits = entry.first;
+                found = true;
+            }
+        }
+
+        if (!found) {
+            bucket.clear();
+            continue;
+        }
+
+        last = minBits;
+        for (const std::pair<Bits, uint32_t>& entry : bucket) {
+            if (isCurrent(entry)) {
+                buckets[bucketIndex(entry.first)].push_back(entry);
+            }
+        }
+        bucket.clear();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Dial's bucket queue: a circular array of buckets of fixed width, holding the elements whose key falls in each
+ * interval of that width. Keys are never further than the maximum edge weight from the current bucket, so that many
+ * buckets are enough for the circular array.
+ *
+ * Only the current bucket is kept ordered (as a binary heap), which is cheap when buckets are as narrow as the lightest
+ * edge, as elements are then rarely inserted into the current bucket and the buckets hold few elements.
+ */
+template <class Key>
+class DialQueue {
+public:
+    explicit DialQueue(const BasicCsrGraph<Key>& graph);
+
+    void reset(const Key* keys, uint32_t numElements);
+    bool empty() const;
+    bool contains(uint32_t v) const;
+
+    void insert(uint32_t v);
+    uint32_t extractMin();
+    void decreaseKey(uint32_t v);
+    void clear();
+
+    Key getBucketWidth() const;
+private:
+    // Limits the number of buckets when edge weights have a very large range (buckets are then wider than the lightest
+    // edge)
+    static const size_t MAX_BUCKETS = 1 << 16;
+
+    Key width = 1;
+    // Entries (key, element), possibly outdated
+    std::vector<std::vector<std::pair<Key, uint32_t>>> buckets;
+    std::vector<uint8_t> queued;
+    const Key* keys = nullptr;
+    uint64_t current = 0;
+    uint32_t size = 0;
+
+    uint64_t bucketNumber(Key key) const;
+    std::vector<std::pair<Key, uint32_t>>& currentBucket();
+    void setCurrent(uint64_t number);
+    void push(uint32_t v);
+};
+
+/**
+ * @brief Creates a queue for searches on a graph, with the width of the buckets equal to the minimum positive edge
+ * weight of the graph.
+ */
+template <class Key>
+inline DialQueue<Key>::DialQueue(const BasicCsrGraph<Key>& graph) {
+    Key minWeight = 0, maxWeight = 0;
+    for (Key weight : graph.weight) {
+        if (weight > 0 && (minWeight == 0 || weight < minWeight)) {
+            minWeight = weight;
+        }
+        maxWeight = std::max(maxWeight, weight);
+    }
+
+    if (minWeight > 0) {
+        width = std::max<Key>(minWeight, maxWeight / (MAX_BUCKETS - 3));
+    }
+    // One more bucket than strictly needed, for rounding errors
+    buckets.resize(static_cast<size_t>(maxWeight / width) + 3);
+}
+
+/**
+ * @brief Prepares the queue for a new search
+ * @param keys          array with the key of every element (non-negative), read when elements are inserted
+ * @param numElements   number of elements that may be inserted (elements are indices in [0, numElements))
+ */
+template <class Key>
+inline void DialQueue<Key>::reset(const Key* keys, uint32_t numElements) {
+    this->keys = keys;
+    clear();
+    if (queued.size() != numElements) {
+        queued.assign(numElements, 0);
+    }
+}
+
+template <class Key>
+inline bool DialQueue<Key>::empty() const {
+    return size == 0;
+}
+
+template <class Key>
+inline bool DialQueue<Key>::contains(uint32_t v) const {
+    return queued[v];
+}
+
+template <class Key>
+inline void DialQueue<Key>::insert(uint32_t v) {
+    if (size == 0) {
+        setCurrent(bucketNumber(keys[v]));
+    }
+    queued[v] = 1;
+    ++size;
+    push(v);
+}
+
+template <class Key>
+inline void DialQueue<Key>::decreaseKey(uint32_t v) {
+    push(v);
+}
+
+/**
+ * @brief Removes and returns the element with the minimum key. The queue must not be empty.
+ */
+template <class Key>
+inline uint32_t DialQueue<Key>::extractMin() {
+    std::greater<std::pair<Key, uint32_t>> compare;
+
+    while (true) {
+        std::vector<std::pair<Key, uint32_t>>& bucket = currentBucket();
+        if (bucket.empty()) {
+            setCurrent(current + 1);
+            continue;
+        }
+
+        std::pop_heap(bucket.begin(), bucket.end(), compare);
+        std::pair<Key, uint32_t> entry = bucket.back();
+        bucket.pop_back();
+
+        if (queued[entry.second] && entry.first == keys[entry.second]) {
+            queued[entry.second] = 0;
+            --size;
+            return entry.second;
+        }
+    }
+}
+
+/**
+ * @brief Removes every element from the queue, in time proportional to the number of buckets and entries.
+ */
+template <class Key>
+inline void DialQueue<Key>::clear() {
+    for (std::vector<std::pair<Key, uint32_t>>& bucket : buckets) {
+        for (const std::pair<Key, uint32_t>& entry : bucket) {
+            queued[entry.second] = 0;
+        }
+        bucket.clear();
+    }
+    current = 0;
+    size = 0;
+}
+
+template <class Key>
+inline Key DialQueue<Key>::getBucketWidth() const {
+    return width;
+}
+
+template <class Key>
+inline uint64_t DialQueue<Key>::bucketNumber(Key key) const {
+    return static_cast<uint64_t>(key / width);
+}
+
+template <class Key>
+inline std::vector<std::pair<Key, uint32_t>>& DialQueue<Key>::currentBucket() {
+    return buckets[current % buckets.size()];
+}
+
+/**
+ * @brief Moves to another bucket, ordering its entries.
+ */
+template <class Key>
+inline void DialQueue<Key>::setCurrent(uint64_t number) {
+    current = number;
+    std::make_heap(currentBucket().begin(), currentBucket().end(), std::greater<std::pair<Key, uint32_t>>());
+}
+
+template <class Key>
+inline void DialQueue<Key>::push(uint32_t v) {
+    // Keys are never smaller than the current bucket in Dijkstra's algorithm, except for rounding errors
+    uint64_t number = std::max(bucketNumber(keys[v]), current);
+    std::vector<std::pair<Key, uint32_t>>& bucket = buckets[number % buckets.size()];
+
+    bucket.push_back({keys[v], v});
+    if (number == current) {
+        std::push_heap(bucket.begin(), bucket.end(), std::greater<std::pair<Key, uint32_t>>());
+    }
+}
+
+#endif // MONOTONE_PRIORITY_QUEUES_H
@@ -2,6 +2,7 @@
 #define POS_INFO_H
 
 #include <iostream>
+#include <functional>
 
 class PosInfo {
 public:
@@ -20,5 +21,13 @@ private:
     float x, y;
 };
 
+namespace std {
+    template<>
+    struct hash<PosInfo> {
+        size_t operator()(const PosInfo& info) const {
+            return hash<unsigned int>()(info.getId());
+        }
+    };
+}
 
 #endif // POS_INFO_H
@@ -0,0 +1,113 @@
+#ifndef PREDECESSOR_TREES_H
+#define PREDECESSOR_TREES_H
+
+#include "CsrGraph.h"
+#include "SearchWorkspace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Shortest path trees of a set of searches (e.g. one per row of the adjacency matrix of the reduction step), pruned to
+ * the paths from the source of each search to its targets. Each tree is stored compactly as a list of (vertex,
+ * predecessor) pairs, so the path from a source to any of its targets can later be rebuilt without searching again.
+ */
+class PredecessorTrees {
+public:
+    void resize(size_t numTrees, uint32_t numVertices);
+    size_t size() const;
+
+    template <class W>
+    void store(size_t tree, uint32_t source, const std::vector<uint32_t>& targets,
+               const BasicSearchWorkspace<W>& workspace);
+
+    uint32_t getSource(size_t tree) const;
+    template <class W>
+    bool path(size_t tree, uint32_t target, BasicSearchWorkspace<W>& workspace, std::vector<uint32_t>& path) const;
+private:
+    uint32_t numVertices = 0;
+    std::vector<uint32_t> sources;
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> trees;
+};
+
+/**
+ * @brief Removes every tree and prepares the given number of empty trees, over a graph with the given number of
+ * vertices. Trees can then be stored concurrently, as long as each of them is stored by a single thread.
+ */
+inline void PredecessorTrees::resize(size_t numTrees, uint32_t numVertices) {
+    this->numVertices = numVertices;
+    sources.assign(numTrees, NO_VERTEX);
+    trees.assign(numTrees, std::vector<std::pair<uint32_t, uint32_t>>());
+}
+
+inline size_t PredecessorTrees::size() const {
+    return trees.size();
+}
+
+/**
+ * @brief Keeps the paths from the source of a search to its targets. Only the predecessors of settled vertices are
+ * read, so the search may have stopped as soon as its targets were settled.
+ * @param tree          index of the tree
+ * @param source        index of the source of the search
+ * @param targets       indices of the targets of the search (the ones it did not reach are ignored)
+ * @param workspace     workspace of the search
+ */
+template <class W>
+inline void PredecessorTrees::store(size_t tree, uint32_t source, const std::vector<uint32_t>& targets,
+                                    const BasicSearchWorkspace<W>& workspace) {
+    std::vector<std::pair<uint32_t, uint32_t>>& edges = trees[tree];
+    sources[tree] = source;
+    edges.clear();
+
+    for (uint32_t target : targets) {
+        if (!workspace.reached(target))
+            continue;
+
+        for (uint32_t v = target; v != source; v = workspace.getPred(v)) {
+            edges.push_back({v, workspace.getPred(v)});
+        }
+    }
+
+    // Paths to different targets share their first vertices
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    edges.shrink_to_fit();
+}
+
+inline uint32_t PredecessorTrees::getSource(size_t tree) const {
+    return sources[tree];
+}
+
+/**
+ * @brief Rebuilds the shortest path from the source of a tree to one of its targets, in time linear in the size of the
+ * tree.
+ * @param tree          index of the tree
+ * @param target        index of the target
+ * @param workspace     workspace where the predecessors of the tree are unpacked (its current search is lost)
+ * @param path          filled with the indices of the vertices of the path, from the source to the target
+ * @return              false if the target is not in the tree, in which case the path is left empty
+ */
+template <class W>
+inline bool PredecessorTrees::path(size_t tree, uint32_t target, BasicSearchWorkspace<W>& workspace,
+                                   std::vector<uint32_t>& path) const {
+    path.clear();
+
+    workspace.reset(numVertices);
+    for (const std::pair<uint32_t, uint32_t>& edge : trees[tree]) {
+        workspace.setDist(edge.first, 0, edge.second);
+    }
+
+    if (target != sources[tree] && !workspace.reached(target))
+        return false;
+
+    for (uint32_t v = target; v != sources[tree]; v = workspace.getPred(v)) {
+        path.push_back(v);
+    }
+    path.push_back(sources[tree]);
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+#endif // PREDECESSOR_TREES_H
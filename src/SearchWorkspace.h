@@ -0,0 +1,232 @@
+#ifndef SEARCH_WORKSPACE_H
+#define SEARCH_WORKSPACE_H
+
+#include "CsrGraph.h"
+#include "IndexedPriorityQueue.h"
+#include "WeightTraits.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Mutable state of a single-source shortest path search, stored as arrays keyed by dense vertex index.
+ *
+ * Keeping this state outside the graph lets a frozen graph be shared read-only between threads, each of them
+ * running its queries on its own workspace. A workspace can be reused for any number of queries, which avoids
+ * reallocating its arrays on every search.
+ *
+ * Every search has a new epoch, and each vertex is stamped with the epoch of the last search which reached it, so the
+ * distances and predecessors left by older searches are recognised as outdated instead of being cleared. Starting a
+ * search therefore costs nothing, and a search costs only what it explores.
+ *
+ * Distances have the weight type W of the graph searched (see WeightTraits).
+ */
+template <class W>
+class BasicSearchWorkspace {
+public:
+    // Distances and predecessors, only valid for the vertices reached by the current search (read them with getDist
+    // and getPred, and write them with setDist)
+    std::vector<W> dist;
+    std::vector<uint32_t> pred;
+    IndexedPriorityQueue<W> queue;
+
+    // Queue keys of goal-directed searches, where they differ from the distances
+    std::vector<W> priority;
+
+    // Marks the targets of a bounded search which have not been settled yet (all zero between searches)
+    std::vector<uint8_t> targetMark;
+
+    // Vertices reached by the current search, in the order they were first reached
+    std::vector<uint32_t> reachedVertices;
+
+    void reset(uint32_t numVertices);
+
+    bool reached(uint32_t v) const;
+    void setDist(uint32_t v, W newDist, uint32_t newPred);
+    W getDist(uint32_t v) const;
+    uint32_t getPred(uint32_t v) const;
+private:
+    // Epoch of the last search which reached each vertex
+    std::vector<uint32_t> stamp;
+    uint32_t epoch = 0;
+};
+
+// Workspace of the searches on float graphs, including those of the contraction hierarchy, landmarks and row cache
+using SearchWorkspace = BasicSearchWorkspace<float>;
+
+/**
+ * @brief Starts a new search, in constant time unless the number of vertices changed
+ */
+template <class W>
+inline void BasicSearchWorkspace<W>::reset(uint32_t numVertices) {
+    if (stamp.size() != numVertices) {
+        dist.assign(numVertices, WeightTraits<W>::infinity());
+        pred.assign(numVertices, NO_VERTEX);
+        stamp.assign(numVertices, 0);
+        targetMark.assign(numVertices, 0);
+        epoch = 0;
+    }
+
+    // When the epoch wraps around, the stamps of every vertex must be cleared once
+    if (++epoch == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        epoch = 1;
+    }
+
+    reachedVertices.clear();
+    queue.reset(dist.data(), numVertices);
+}
+
+/**
+ * @brief Checks if a vertex has been reached by the current search, i.e. if it has a finite distance
+ */
+template <class W>
+inline bool BasicSearchWorkspace<W>::reached(uint32_t v) const {
+    return stamp[v] == epoch;
+}
+
+/**
+ * @brief Sets the tentative distance and predecessor of a vertex in the current search
+ */
+template <class W>
+inline void BasicSearchWorkspace<W>::setDist(uint32_t v, W newDist, uint32_t newPred) {
+    if (stamp[v] != epoch) {
+        stamp[v] = epoch;
+        reachedVertices.push_back(v);
+    }
+    dist[v] = newDist;
+    pred[v] = newPred;
+}
+
+/**
+ * @return  distance of a vertex in the current search (infinite if it has not been reached)
+ */
+template <class W>
+inline W BasicSearchWorkspace<W>::getDist(uint32_t v) const {
+    return stamp[v] == epoch ? dist[v] : WeightTraits<W>::infinity();
+}
+
+/**
+ * @return  predecessor of a vertex in the current search (NO_VERTEX for the source and for unreached vertices)
+ */
+template <class W>
+inline uint32_t BasicSearchWorkspace<W>::getPred(uint32_t v) const {
+    return stamp[v] == epoch ? pred[v] : NO_VERTEX;
+}
+
+/**
+ * @brief Calculates the shortest path from a given vertex to all others using Dijkstra's algorithm, with a given
+ * priority queue.
+ * @param graph         CSR graph (or view) to search
+ * @param source        index of the source vertex
+ * @param workspace     workspace where the distances and predecessors of every vertex are left
+ * @param queue         priority queue with the interface of IndexedPriorityQueue<W>, used instead of the one of the
+ * workspace
+ */
+template <class Csr, class W, class Queue>
+void dijkstraOverCsr(const Csr& graph, uint32_t source, BasicSearchWorkspace<W>& workspace, Queue& queue) {
+    workspace.reset(graph.numVertices());
+    queue.reset(workspace.dist.data(), graph.numVertices());
+
+    workspace.setDist(source, 0, NO_VERTEX);
+    queue.insert(source);
+
+    while (!queue.empty()) {
+        uint32_t v = queue.extractMin();
+        W vDist = workspace.dist[v];
+
+        for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+            uint32_t w = graph.dest[e];
+            W newDist = WeightTraits<W>::add(vDist, graph.weight[e]);
+
+            if (workspace.getDist(w) > newDist) {
+                workspace.setDist(w, newDist, v);
+
+                if (queue.contains(w)) {
+                    queue.decreaseKey(w);
+                }
+                else {
+                    queue.insert(w);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Calculates the shortest path from a given vertex to all others using Dijkstra's algorithm.
+ * @param graph         CSR graph (or view) to search
+ * @param source        index of the source vertex
+ * @param workspace     workspace where the distances and predecessors of every vertex are left
+ */
+template <class Csr, class W>
+void dijkstraOverCsr(const Csr& graph, uint32_t source, BasicSearchWorkspace<W>& workspace) {
+    dijkstraOverCsr(graph, source, workspace, workspace.queue);
+}
+
+/**
+ * @brief Dijkstra's algorithm restricted to what is needed to know the distances to a set of targets. The search
+ * stops as soon as every target has been settled, and never relaxes an edge leading further than the cutoff distance.
+ * Afterwards, the distance of every target is final, and targets that are unreachable or further than the cutoff are
+ * left at infinity. The distances of the other vertices may be tentative.
+ * @param graph         CSR graph (or view) to search
+ * @param source        index of the source vertex
+ * @param targets       indices of the target vertices
+ * @param cutoff        maximum distance of interest
+ * @param workspace     workspace where the distances and predecessors of the vertices are left
+ */
+template <class Csr, class W>
+void dijkstraOverCsr(const Csr& graph, uint32_t source, const std::vector<uint32_t>& targets, W cutoff,
+                     BasicSearchWorkspace<W>& workspace) {
+    workspace.reset(graph.numVertices());
+    IndexedPriorityQueue<W>& queue = workspace.queue;
+    std::vector<uint8_t>& targetMark = workspace.targetMark;
+
+    size_t remainingTargets = 0;
+    for (uint32_t target : targets) {
+        if (!targetMark[target]) {
+            targetMark[target] = 1;
+            ++remainingTargets;
+        }
+    }
+
+    workspace.setDist(source, 0, NO_VERTEX);
+    queue.insert(source);
+
+    while (!queue.empty() && remainingTargets > 0) {
+        uint32_t v = queue.extractMin();
+        W vDist = workspace.dist[v];
+
+        if (targetMark[v]) {
+            targetMark[v] = 0;
+            if (--remainingTargets == 0)
+                break;
+        }
+
+        for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+            uint32_t w = graph.dest[e];
+            W newDist = WeightTraits<W>::add(vDist, graph.weight[e]);
+
+            if (newDist <= cutoff && workspace.getDist(w) > newDist) {
+                bool notInQueue = !workspace.reached(w);
+                workspace.setDist(w, newDist, v);
+
+                if (notInQueue) {
+                    queue.insert(w);
+                }
+                else {
+                    queue.decreaseKey(w);
+                }
+            }
+        }
+    }
+
+    queue.clear();
+    for (uint32_t target : targets) {
+        targetMark[target] = 0;
+    }
+}
+
+#endif // SEARCH_WORKSPACE_H
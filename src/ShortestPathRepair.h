@@ -0,0 +1,111 @@
+#ifndef SHORTEST_PATH_REPAIR_H
+#define SHORTEST_PATH_REPAIR_H
+
+#include "CsrGraph.h"
+#include "SearchWorkspace.h"
+#include "WeightTraits.h"
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief Repairs a shortest path tree after the edges from one vertex to another changed (their weights were updated,
+ * or they were removed), re-settling only the vertices whose distances may have changed, instead of searching again.
+ *
+ * If the change makes the vertex reached by the edges closer, the improvement is propagated from it by a Dijkstra
+ * search that only visits vertices whose distances decrease. Otherwise, if the tree goes through the changed edges, the
+ * subtree below them is cut off, each of its vertices gets its best distance through the edges entering it from the
+ * rest of the tree, and a Dijkstra search restricted to the subtree settles them again. Any other change leaves the
+ * tree as it was.
+ *
+ * Changes must be repaired one at a time, as soon as they are made.
+ *
+ * @param graph     CSR graph, already with the changed edges
+ * @param reverse   reverse of the CSR graph, also already changed
+ * @param source    index of the source of the tree
+ * @param from      index of the vertex the changed edges leave
+ * @param to        index of the vertex the changed edges enter
+ * @param dist      distance from the source to every vertex (infinite if unreachable), repaired in place
+ * @param pred      predecessor of every vertex in the tree (any value for the source), repaired in place
+ * @param none      value of pred for the vertices the source does not reach
+ * @param workspace workspace whose queue and epoch stamps are used for the repair (its current search is lost)
+ */
+template <class Pred, class W>
+void repairShortestPathTree(const BasicCsrGraph<W>& graph, const BasicCsrGraph<W>& reverse, uint32_t source,
+                            uint32_t from, uint32_t to, W* dist, Pred* pred, Pred none,
+                            BasicSearchWorkspace<W>& workspace) {
+    const W INF = WeightTraits<W>::infinity();
+
+    // The workspace only marks the vertices of the cut off subtree, and the queue is keyed by the distances of the tree
+    workspace.reset(graph.numVertices());
+    IndexedPriorityQueue<W>& queue = workspace.queue;
+    queue.reset(dist, graph.numVertices());
+
+    W weight = INF;
+    for (uint32_t e = graph.edgesBegin(from); e < graph.edgesEnd(from); ++e) {
+        if (graph.dest[e] == to) {
+            weight = std::min(weight, graph.weight[e]);
+        }
+    }
+
+    if (dist[from] != INF && weight != INF && dist[from] + weight < dist[to]) {
+        dist[to] = dist[from] + weight;
+        pred[to] = static_cast<Pred>(from);
+        queue.insert(to);
+    }
+    else if (to != source && pred[to] == static_cast<Pred>(from)) {
+        // reachedVertices grows while it is scanned, with the children of every vertex of the subtree
+        workspace.setDist(to, 0, NO_VERTEX);
+        for (size_t i = 0; i < workspace.reachedVertices.size(); ++i) {
+            uint32_t v = workspace.reachedVertices[i];
+            for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+                uint32_t w = graph.dest[e];
+                if (w != source && !workspace.reached(w) && pred[w] == static_cast<Pred>(v)) {
+                    workspace.setDist(w, 0, v);
+                }
+            }
+        }
+
+        for (uint32_t v : workspace.reachedVertices) {
+            dist[v] = INF;
+            pred[v] = none;
+        }
+
+        for (uint32_t v : workspace.reachedVertices) {
+            for (uint32_t e = reverse.edgesBegin(v); e < reverse.edgesEnd(v); ++e) {
+                uint32_t u = reverse.dest[e];
+                if (!workspace.reached(u) && dist[u] != INF && dist[u] + reverse.weight[e] < dist[v]) {
+                    dist[v] = dist[u] + reverse.weight[e];
+                    pred[v] = static_cast<Pred>(u);
+                }
+            }
+            if (dist[v] != INF) {
+                queue.insert(v);
+            }
+        }
+    }
+
+    // Only vertices whose distances decrease are queued, so the search never leaves the affected part of the tree
+    while (!queue.empty()) {
+        uint32_t v = queue.extractMin();
+
+        for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+            uint32_t w = graph.dest[e];
+            W newDist = WeightTraits<W>::add(dist[v], graph.weight[e]);
+
+            if (newDist < dist[w]) {
+                dist[w] = newDist;
+                pred[w] = static_cast<Pred>(v);
+
+                if (queue.contains(w)) {
+                    queue.decreaseKey(w);
+                }
+                else {
+                    queue.insert(w);
+                }
+            }
+        }
+    }
+}
+
+#endif // SHORTEST_PATH_REPAIR_H
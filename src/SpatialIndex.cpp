@@ -0,0 +1,131 @@
+#include "SpatialIndex.h"
+#include "CsrGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Builds the tree, in O(n log n) time.
+ * @param x     first coordinate of each point
+ * @param y     second coordinate of each point
+ * @param ids   id of each point, returned by the queries
+ */
+SpatialIndex::SpatialIndex(const std::vector<float>& x, const std::vector<float>& y, const std::vector<uint32_t>& ids) {
+    points.reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        points.push_back({x[i], y[i], ids[i]});
+    }
+    build(0, points.size(), true);
+}
+
+size_t SpatialIndex::size() const {
+    return points.size();
+}
+
+/**
+ * @brief Finds the point closest to the given coordinates, visiting O(log n) points on average.
+ * @return  id of the point (NO_VERTEX if the index is empty)
+ */
+uint32_t SpatialIndex::nearest(float x, float y) const {
+    uint32_t best = NO_VERTEX;
+    float bestDist = std::numeric_limits<float>::max();
+    nearest(0, points.size(), true, x, y, best, bestDist);
+    return best;
+}
+
+/**
+ * @brief Finds the points inside an ellipse, i.e. whose distances to its two foci add up to no more than a maximum.
+ * Subtrees whose bounding boxes lie outside the ellipse are skipped without visiting their points.
+ * @return  ids of the points inside the ellipse, in no particular order
+ */
+std::vector<uint32_t> SpatialIndex::withinEllipse(float x1, float y1, float x2, float y2, float maxDistance) const {
+    const float INF = std::numeric_limits<float>::infinity();
+
+    std::vector<uint32_t> output;
+    withinEllipse(0, points.size(), true, {-INF, -INF, INF, INF}, x1, y1, x2, y2, maxDistance, output);
+    return output;
+}
+
+void SpatialIndex::build(size_t begin, size_t end, bool splitX) {
+    if (end - begin <= 1)
+        return;
+
+    size_t middle = begin + (end - begin) / 2;
+    std::nth_element(points.begin() + begin, points.begin() + middle, points.begin() + end,
+                     [splitX](const Point& a, const Point& b) {
+        return splitX ? a.x < b.x : a.y < b.y;
+    });
+
+    build(begin, middle, !splitX);
+    build(middle + 1, end, !splitX);
+}
+
+void SpatialIndex::nearest(size_t begin, size_t end, bool splitX, float x, float y, uint32_t& best,
+                           float& bestDist) const {
+    if (begin >= end)
+        return;
+
+    size_t middle = begin + (end - begin) / 2;
+    const Point& point = points[middle];
+
+    float dist = std::hypot(point.x - x, point.y - y);
+    if (dist < bestDist) {
+        bestDist = dist;
+        best = point.id;
+    }
+
+    // The side of the splitting line where the coordinates are is searched first, and the other side only if it may
+    // have a closer point
+    float offset = splitX ? x - point.x : y - point.y;
+    if (offset < 0) {
+        nearest(begin, middle, !splitX, x, y, best, bestDist);
+        if (-offset < bestDist) {
+            nearest(middle + 1, end, !splitX, x, y, best, bestDist);
+        }
+    }
+    else {
+        nearest(middle + 1, end, !splitX, x, y, best, bestDist);
+        if (offset < bestDist) {
+            nearest(begin, middle, !splitX, x, y, best, bestDist);
+        }
+    }
+}
+
+/**
+ * @return  distance from a point to the closest point of a box (0 if it is inside the box)
+ */
+static float distanceToBox(float x, float y, float minX, float minY, float maxX, float maxY) {
+    float dx = x < minX ? minX - x : (x > maxX ? x - maxX : 0);
+    float dy = y < minY ? minY - y : (y > maxY ? y - maxY : 0);
+    return std::hypot(dx, dy);
+}
+
+void SpatialIndex::withinEllipse(size_t begin, size_t end, bool splitX, const Box& box, float x1, float y1, float x2,
+                                 float y2, float maxDistance, std::vector<uint32_t>& output) const {
+    if (begin >= end)
+        return;
+
+    // No point of the box is closer to both foci than the box itself
+    if (distanceToBox(x1, y1, box.minX, box.minY, box.maxX, box.maxY) +
+        distanceToBox(x2, y2, box.minX, box.minY, box.maxX, box.maxY) > maxDistance)
+        return;
+
+    size_t middle = begin + (end - begin) / 2;
+    const Point& point = points[middle];
+
+    if (std::hypot(point.x - x1, point.y - y1) + std::hypot(point.x - x2, point.y - y2) <= maxDistance) {
+        output.push_back(point.id);
+    }
+
+    Box lower = box, upper = box;
+    if (splitX) {
+        lower.maxX = upper.minX = point.x;
+    }
+    else {
+        lower.maxY = upper.minY = point.y;
+    }
+
+    withinEllipse(begin, middle, !splitX, lower, x1, y1, x2, y2, maxDistance, output);
+    withinEllipse(middle + 1, end, !splitX, upper, x1, y1, x2, y2, maxDistance, output);
+}
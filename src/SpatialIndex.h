@@ -0,0 +1,44 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Static k-d tree over points of the plane, each with an id (e.g. the dense index of a vertex, or the position of a
+ * point of interest in its list), for geometric queries that would otherwise scan every point.
+ *
+ * The tree is implicit: the points are reordered so that the median of each range (along x at even depths and along y
+ * at odd ones) sits in its middle, with the points before it no greater and the points after it no smaller. Distances
+ * are euclidean, so with map coordinates they are lower bounds of the distances in the graph only if its edge weights
+ * are euclidean too.
+ */
+class SpatialIndex {
+public:
+    SpatialIndex() = default;
+    SpatialIndex(const std::vector<float>& x, const std::vector<float>& y, const std::vector<uint32_t>& ids);
+
+    size_t size() const;
+    uint32_t nearest(float x, float y) const;
+    std::vector<uint32_t> withinEllipse(float x1, float y1, float x2, float y2, float maxDistance) const;
+private:
+    struct Point {
+        float x, y;
+        uint32_t id;
+    };
+
+    // Bounding box of the points of a subtree
+    struct Box {
+        float minX, minY, maxX, maxY;
+    };
+
+    std::vector<Point> points;
+
+    void build(size_t begin, size_t end, bool splitX);
+    void nearest(size_t begin, size_t end, bool splitX, float x, float y, uint32_t& best, float& bestDist) const;
+    void withinEllipse(size_t begin, size_t end, bool splitX, const Box& box, float x1, float y1, float x2, float y2,
+                       float maxDistance, std::vector<uint32_t>& output) const;
+};
+
+#endif // SPATIAL_INDEX_H
@@ -0,0 +1,86 @@
+#include "ThreadPool.h"
+
+/**
+ * @brief Creates the pool. The thread calling parallelFor also works on the loop, so only numThreads - 1 threads
+ * are actually created.
+ * @param numThreads    number of workers (if 0, a single worker is used)
+ */
+ThreadPool::ThreadPool(unsigned numThreads) : nextIndex(0) {
+    for (unsigned worker = 1; worker < numThreads; ++worker) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+}
+
+unsigned ThreadPool::size() const {
+    return workers.size() + 1;
+}
+
+/**
+ * @brief Runs a task for every index in [0, count), distributing the indices dynamically among the workers, and
+ * waits for all of them to finish. Worker numbers are in [0, size()), so they can be used to index per-worker state.
+ * Must not be called concurrently from several threads.
+ */
+void ThreadPool::parallelFor(size_t count, const Task& task) {
+    if (workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(0, i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        taskCount = count;
+        nextIndex = 0;
+        activeWorkers = workers.size();
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    runTask(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+    currentTask = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    unsigned long seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [this, seenGeneration] { return stopping || generation != seenGeneration; });
+            if (stopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        runTask(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--activeWorkers == 0) {
+            doneCondition.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runTask(unsigned worker) {
+    size_t index;
+    while ((index = nextIndex.fetch_add(1)) < taskCount) {
+        (*currentTask)(worker, index);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads for data-parallel loops. The threads are created once and sleep between
+ * loops, so a parallel loop costs a wake-up instead of a thread creation per worker.
+ */
+class ThreadPool {
+public:
+    /** Task run for every index of a parallel loop, receiving the number of the worker running it. */
+    using Task = std::function<void(unsigned worker, size_t index)>;
+
+    explicit ThreadPool(unsigned numThreads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const;
+
+    void parallelFor(size_t count, const Task& task);
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    bool stopping = false;
+    unsigned long generation = 0;
+    unsigned activeWorkers = 0;
+
+    const Task* currentTask = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> nextIndex;
+
+    void workerLoop(unsigned worker);
+    void runTask(unsigned worker);
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,92 @@
+#ifndef WEIGHT_TRAITS_H
+#define WEIGHT_TRAITS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+/*
+ * Weight types of the graph and of the adjacency matrices given to the CCTSP step. Each specialisation of WeightTraits
+ * defines the value meaning "no path", an addition which saturates at that value instead of overflowing, and the
+ * conversions from and to float distances, so the graph, its searches and the solvers can be instantiated for any of
+ * them:
+ *  - float, the default;
+ *  - double, for costs summed over long tours;
+ *  - uint32_t, fixed point with a resolution of 1/SCALE units, so costs are compared exactly and the monotone queues
+ *    work on the integer keys directly.
+ *
+ * The contraction hierarchy, the landmarks, the row cache, the Floyd-Warshall matrices and the map snapshots are only
+ * built for float graphs.
+ */
+
+template <class W>
+struct WeightTraits;
+
+template <>
+struct WeightTraits<float> {
+    static float infinity() { return std::numeric_limits<float>::max(); }
+    static float add(float a, float b) { return std::min(a + b, infinity()); }
+    static float fromFloat(float weight) { return weight; }
+    static float toFloat(float weight) { return weight; }
+};
+
+template <>
+struct WeightTraits<double> {
+    static double infinity() { return std::numeric_limits<double>::max(); }
+    static double add(double a, double b) { return std::min(a + b, infinity()); }
+
+    static double fromFloat(float weight) {
+        return weight == std::numeric_limits<float>::max() ? infinity() : weight;
+    }
+
+    static float toFloat(double weight) {
+        return weight >= std::numeric_limits<float>::max() ? std::numeric_limits<float>::max() : weight;
+    }
+};
+
+template <>
+struct WeightTraits<uint32_t> {
+    // Fixed point units per unit of the graph's weights
+    static constexpr float SCALE = 1000;
+
+    static uint32_t infinity() { return UINT32_MAX; }
+
+    static uint32_t add(uint32_t a, uint32_t b) {
+        return a > UINT32_MAX - b ? UINT32_MAX : a + b;
+    }
+
+    // Weights too large to be represented (including MAX_FLOAT) become infinite
+    static uint32_t fromFloat(float weight) {
+        float scaled = std::round(weight * SCALE);
+        return scaled >= static_cast<float>(UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(scaled);
+    }
+
+    static float toFloat(uint32_t weight) {
+        return weight == UINT32_MAX ? std::numeric_limits<float>::max() : weight / SCALE;
+    }
+};
+
+/**
+ * Conversion between two weight types, through the float distances both of them convert from and to. Weights of the
+ * same type are returned unchanged, so fixed point weights keep their exact value.
+ */
+template <class To, class From>
+struct WeightConversion {
+    static To convert(From weight) { return WeightTraits<To>::fromFloat(WeightTraits<From>::toFloat(weight)); }
+};
+
+template <class W>
+struct WeightConversion<W, W> {
+    static W convert(W weight) { return weight; }
+};
+
+/**
+ * @brief Converts a weight (e.g. a distance of the graph) to another weight type (e.g. that of the CCTSP step).
+ */
+template <class To, class From>
+To convertWeight(From weight) {
+    return WeightConversion<To, From>::convert(weight);
+}
+
+#endif // WEIGHT_TRAITS_H
@@ -1,4 +1,5 @@
 #include "branchAndBound.h"
+#include "WeightTraits.h"
 
 #include <utility>
 #include <queue>
@@ -7,15 +8,18 @@
 
 using namespace std;
 
+namespace {
+
 // Vertex in the sense of the B&B algorithm solution search tree
+template <class W>
 class Vertex {
 private:
     vector<int> path;
     vector<int> unusedVertices;
-    float pathCost;
+    W pathCost;
     float score;
 public:
-    explicit Vertex(const vector<vector<float>> &adjMatrix)  {
+    explicit Vertex(const vector<vector<W>> &adjMatrix)  {
         path.reserve(adjMatrix.size());
         unusedVertices.reserve(adjMatrix.size());
 
@@ -27,21 +31,21 @@ public:
         score = 0;
     }
 
-    Vertex(vector<int> path, vector<int> unusedVertices, float pathCost, float score) :
+    Vertex(vector<int> path, vector<int> unusedVertices, W pathCost, float score) :
     path(std::move(path)), unusedVertices(std::move(unusedVertices)), pathCost(pathCost), score(score) {}
 
     bool isAtBottom() const {
         return unusedVertices.empty();
     }
 
-    vector<Vertex> getValidChildren(const vector<vector<float>> &adjMatrix, const vector<float> &scores, const float budget) const {
+    vector<Vertex> getValidChildren(const vector<vector<W>> &adjMatrix, const vector<float> &scores, const W budget) const {
         vector<Vertex> res;
         for (int i = 0; i < unusedVertices.size(); i++) {
             int index = unusedVertices[i];
 
             int lastPathIndex = path[path.size() - 1];
-            float newCost = pathCost - adjMatrix[lastPathIndex][0]
-                    + adjMatrix[lastPathIndex][index] + adjMatrix[index][0];
+            W newCost = WeightTraits<W>::add(WeightTraits<W>::add(pathCost - adjMatrix[lastPathIndex][0],
+                    adjMatrix[lastPathIndex][index]), adjMatrix[index][0]);
 
             float newScore = score + scores[index - 1];
 
@@ -72,32 +76,35 @@ public:
         return score;
     }
 
-    float getCost() const {
+    W getCost() const {
         return pathCost;
     }
 };
 
+}
+
+template <class W>
 vector<int>
-branchAndBound(const vector<vector<float>> &adjMatrix, const vector<float> &scores, const float budget) {
+branchAndBound(const vector<vector<W>> &adjMatrix, const vector<float> &scores, const W budget) {
     int mSize = adjMatrix.size();
     if (scores.size() != mSize - 1) {
         cerr << "Invalid args" << endl;
         exit(1);
     }
-    for (const vector<float> &i : adjMatrix) {
+    for (const vector<W> &i : adjMatrix) {
         if (i.size() != mSize) {
             cerr << "Invalid args" << endl;
             exit(1);
         }
     }
 
-    Vertex currentBest = Vertex(adjMatrix);
+    Vertex<W> currentBest = Vertex<W>(adjMatrix);
 
-    queue<Vertex> solutions;
+    queue<Vertex<W>> solutions;
     solutions.push(currentBest);
 
     while (!solutions.empty()) {
-        Vertex candidate = solutions.front();
+        Vertex<W> candidate = solutions.front();
         solutions.pop();
 
         if (candidate.betterThan(currentBest)) {
@@ -108,12 +115,17 @@ branchAndBound(const vector<vector<float>> &adjMatrix, const vector<float> &scor
             break;
         }
 
-        for (Vertex &child : candidate.getValidChildren(adjMatrix, scores, budget)) {
+        for (Vertex<W> &child : candidate.getValidChildren(adjMatrix, scores, budget)) {
             solutions.push(std::move(child));
         }
     }
 
-    cout << "Path score: " << currentBest.getScore() << " | Path cost: " << currentBest.getCost() << endl;
+    cout << "Path score: " << currentBest.getScore()
+         << " | Path cost: " << WeightTraits<W>::toFloat(currentBest.getCost()) << endl;
 
     return currentBest.getPath();
 }
+
+template vector<int> branchAndBound(const vector<vector<float>> &, const vector<float> &, float);
+template vector<int> branchAndBound(const vector<vector<double>> &, const vector<float> &, double);
+template vector<int> branchAndBound(const vector<vector<uint32_t>> &, const vector<float> &, uint32_t);
@@ -1,17 +1,20 @@
 #ifndef BRANCH_AND_BOUND_H
 #define BRANCH_AND_BOUND_H
 
+#include <cstdint>
 #include <vector>
 
 /**
  * @brief Calculates the best route using the branch and bound method.
- * @param adjMatrix     adjacency matrix of the start vertex and the points of interest
+ * @param adjMatrix     adjacency matrix of the start vertex and the points of interest, with weights of any type
+ * with WeightTraits (instantiated for float, double and uint32_t)
  * @param scores        list of scores of the points of interest
  * @param budget        maximum budget
  * @return              list of indices of the matrix corresponding to the visited points
  */
+template <class W>
 std::vector<int>
-branchAndBound(const std::vector<std::vector<float>> &adjMatrix, const std::vector<float> &scores, float budget);
+branchAndBound(const std::vector<std::vector<W>> &adjMatrix, const std::vector<float> &scores, W budget);
 
 
 #endif // BRANCH_AND_BOUND_H
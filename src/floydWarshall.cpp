@@ -0,0 +1,111 @@
+#include "floydWarshall.h"
+
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Relaxes the paths from the vertices in [iBegin, iEnd) to the vertices in [jBegin, jEnd) through each of the
+ * intermediate vertices in [kBegin, kEnd).
+ *
+ * The inner loop is a branch-free min-plus update. A missing path is represented by MAX_FLOAT, and since weights are
+ * not negative, adding anything to it gives MAX_FLOAT or infinity, which is never smaller than the current value, so
+ * no overflow check is needed.
+ */
+static void relaxTile(FlatMatrix<float>& weight, FlatMatrix<int32_t>& path,
+                      size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd, size_t kBegin, size_t kEnd) {
+    for (size_t k = kBegin; k < kEnd; ++k) {
+        const float* weightK = weight[k];
+        const int32_t* pathK = path[k];
+
+        for (size_t i = iBegin; i < iEnd; ++i) {
+            float* weightI = weight[i];
+            int32_t* pathI = path[i];
+            const float weightIK = weightI[k];
+
+            size_t j = jBegin;
+#ifdef __AVX2__
+            const __m256 weightIKVector = _mm256_set1_ps(weightIK);
+            for (; j + 8 <= jEnd; j += 8) {
+                __m256 candidate = _mm256_add_ps(weightIKVector, _mm256_loadu_ps(weightK + j));
+                __m256 current = _mm256_loadu_ps(weightI + j);
+                __m256 better = _mm256_cmp_ps(candidate, current, _CMP_LT_OQ);
+
+                _mm256_storeu_ps(weightI + j, _mm256_blendv_ps(current, candidate, better));
+
+                __m256i currentPath = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pathI + j));
+                __m256i candidatePath = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pathK + j));
+                __m256i newPath = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(currentPath),
+                        _mm256_castsi256_ps(candidatePath), better));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(pathI + j), newPath);
+            }
+#endif
+            // Portable loop, auto-vectorized by the compiler (the predecessor is selected with a mask instead of a
+            // conditional, which the vectorizer would not if-convert)
+            for (; j < jEnd; ++j) {
+                float current = weightI[j];
+                float candidate = weightIK + weightK[j];
+                int32_t better = -static_cast<int32_t>(candidate < current);
+                weightI[j] = candidate < current ? candidate : current;
+                pathI[j] = (pathK[j] & better) | (pathI[j] & ~better);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs a task for every index in [0, count), on the workers of a pool if there is one. Either way, it only
+ * returns once every index is done, which is the barrier between the phases of the blocked algorithm.
+ */
+static void runPhase(ThreadPool* pool, size_t count, const ThreadPool::Task& task) {
+    if (pool != nullptr) {
+        pool->parallelFor(count, task);
+        return;
+    }
+
+    for (size_t index = 0; index < count; ++index) {
+        task(0, index);
+    }
+}
+
+void floydWarshallBlocked(FlatMatrix<float>& weight, FlatMatrix<int32_t>& path, ThreadPool* pool) {
+    const size_t n = weight.numRows();
+    const size_t B = FLOYD_WARSHALL_BLOCK_SIZE;
+    const size_t numBlocks = (n + B - 1) / B;
+
+    for (size_t kBlock = 0; kBlock < numBlocks; ++kBlock) {
+        size_t kBegin = kBlock * B;
+        size_t kEnd = std::min(kBegin + B, n);
+
+        // Phase 1: the diagonal tile depends only on itself
+        relaxTile(weight, path, kBegin, kEnd, kBegin, kEnd, kBegin, kEnd);
+
+        // Phase 2: the tiles in the same row and column as the diagonal tile depend on themselves and on it
+        runPhase(pool, 2 * numBlocks, [&](unsigned, size_t tile) {
+            size_t block = tile / 2;
+            if (block == kBlock)
+                return;
+            size_t begin = block * B;
+            size_t end = std::min(begin + B, n);
+
+            if (tile % 2 == 0) {
+                relaxTile(weight, path, kBegin, kEnd, begin, end, kBegin, kEnd);
+            }
+            else {
+                relaxTile(weight, path, begin, end, kBegin, kEnd, kBegin, kEnd);
+            }
+        });
+
+        // Phase 3: every other tile depends only on the tiles of phase 2 in its row and column
+        runPhase(pool, numBlocks * numBlocks, [&](unsigned, size_t tile) {
+            size_t iBlock = tile / numBlocks, jBlock = tile % numBlocks;
+            if (iBlock == kBlock || jBlock == kBlock)
+                return;
+            size_t iBegin = iBlock * B, jBegin = jBlock * B;
+
+            relaxTile(weight, path, iBegin, std::min(iBegin + B, n), jBegin, std::min(jBegin + B, n), kBegin, kEnd);
+        });
+    }
+}
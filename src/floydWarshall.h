@@ -0,0 +1,25 @@
+#ifndef FLOYD_WARSHALL_H
+#define FLOYD_WARSHALL_H
+
+#include "FlatMatrix.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+
+// Side of the square tiles processed by the blocked Floyd-Warshall kernel
+constexpr size_t FLOYD_WARSHALL_BLOCK_SIZE = 64;
+
+/**
+ * @brief Calculates the shortest paths for every pair of vertices with a blocked (tiled) Floyd-Warshall kernel.
+ * Each round k of the classic algorithm is replaced by a round over a block of BLOCK_SIZE intermediate vertices, which
+ * relaxes the diagonal tile first, then the tiles in its row and column, and finally every remaining tile, so that
+ * the three tiles involved in each step stay in cache.
+ * @param weight    square matrix with the cost of each edge (0 in the diagonal and MAX_FLOAT where there is no edge),
+ * replaced by the cost of the shortest paths; weights must not be negative
+ * @param path      square matrix with the predecessor of j in the path from i in position (i, j) (i for edges, -1
+ * where there is no edge), replaced by the predecessors in the shortest paths
+ * @param pool      if not null, the tiles of each phase are relaxed in parallel by the workers of the pool
+ */
+void floydWarshallBlocked(FlatMatrix<float>& weight, FlatMatrix<int32_t>& path, ThreadPool* pool = nullptr);
+
+#endif // FLOYD_WARSHALL_H
@@ -0,0 +1,102 @@
+/*
+ * Micro-benchmark of the priority queue policies of Dijkstra's algorithm. Runs full searches with every policy on the
+ * grid maps and on random graphs of increasing size (with float and with fixed point weights, whose integer keys the
+ * monotone queues use directly), and prints the average time per search as CSV, so the fastest policy can be chosen for
+ * each kind of map.
+ *
+ * Must be run from the src/ folder, like the main program.
+ */
+
+#include "Graph.h"
+#include "HeapPolicies.h"
+#include "MonotonePriorityQueues.h"
+#include "parsing.h"
+#include "randomGraphs.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Runs a search from each of the sources with a given priority queue, returning the average time per search in
+ * microseconds. The graph must be frozen.
+ */
+template <class T, class W, class Queue>
+static double timeSearches(const Graph<T, W>& graph, const std::vector<Vertex<T, W>*>& sources, Queue& queue) {
+    BasicSearchWorkspace<W> workspace;
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (const Vertex<T, W>* source : sources) {
+        graph.dijkstra(source, workspace, queue);
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / 1000.0 / sources.size();
+}
+
+/**
+ * @brief Prints a CSV line with the average search time of every policy on a graph, over a given number of searches
+ * from sources spread evenly over the vertex set (repeated if there are more searches than vertices).
+ */
+template <class T, class W>
+static void benchmarkGraph(const std::string& name, Graph<T, W>& graph, size_t numSearches) {
+    graph.freeze();
+
+    std::vector<Vertex<T, W>*> vertexSet = graph.getVertexSet();
+    std::vector<Vertex<T, W>*> sources;
+    for (size_t i = 0; i < numSearches; ++i) {
+        sources.push_back(vertexSet[i * vertexSet.size() / numSearches % vertexSet.size()]);
+    }
+
+    BinaryHeap<W> binaryHeap;
+    FourAryHeap<W> fourAryHeap;
+    EightAryHeap<W> eightAryHeap;
+    PairingHeap<W> pairingHeap;
+    LazyBinaryHeap<W> lazyBinaryHeap;
+    RadixHeap<W> radixHeap;
+    DialQueue<W> dial(graph.getCsr());
+
+    std::cout << name << ", " << vertexSet.size() << ", " << graph.getCsr().numEdges()
+              << ", " << timeSearches(graph, sources, binaryHeap)
+              << ", " << timeSearches(graph, sources, fourAryHeap)
+              << ", " << timeSearches(graph, sources, eightAryHeap)
+              << ", " << timeSearches(graph, sources, pairingHeap)
+              << ", " << timeSearches(graph, sources, lazyBinaryHeap)
+              << ", " << timeSearches(graph, sources, radixHeap)
+              << ", " << timeSearches(graph, sources, dial) << std::endl;
+}
+
+int main() {
+    const std::vector<std::string> GRID_MAPS = {"4x4", "8x8", "16x16"};
+    const std::vector<int> RANDOM_GRAPH_SIZES = {1000, 10000, 100000};
+    const size_t NUM_GRID_SEARCHES = 1000;
+    const size_t NUM_RANDOM_SEARCHES = 10;
+
+    std::cout << "graph, numVertices, numEdges, binary heap (microseconds), 4-ary heap (microseconds), "
+                 "8-ary heap (microseconds), pairing heap (microseconds), lazy binary heap (microseconds), "
+                 "radix heap (microseconds), Dial buckets (microseconds)" << std::endl;
+
+    for (const std::string& map : GRID_MAPS) {
+        Graph<PosInfo> graph;
+        parseVertexFile("maps/" + map + "/nodes.txt", graph);
+        parseEdgeFile("maps/" + map + "/edges.txt", graph, false);
+        benchmarkGraph(map, graph, NUM_GRID_SEARCHES);
+    }
+
+    for (int n : RANDOM_GRAPH_SIZES) {
+        Graph<int> graph;
+        std::vector<Vertex<int>*> pointsOfInterest;
+        generateRandomGraph(graph, pointsOfInterest, n);
+        benchmarkGraph("random", graph, NUM_RANDOM_SEARCHES);
+    }
+
+    for (int n : RANDOM_GRAPH_SIZES) {
+        Graph<int, uint32_t> graph;
+        std::vector<Vertex<int, uint32_t>*> pointsOfInterest;
+        generateRandomGraph(graph, pointsOfInterest, n);
+        benchmarkGraph("random fixed point", graph, NUM_RANDOM_SEARCHES);
+    }
+
+    return 0;
+}
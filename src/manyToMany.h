@@ -0,0 +1,256 @@
+#ifndef MANY_TO_MANY_H
+#define MANY_TO_MANY_H
+
+#include "CsrGraph.h"
+#include "SearchWorkspace.h"
+#include "ContractionHierarchy.h"
+#include "WeightTraits.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+/**
+ * Distances from the vertices reached by the backward searches of a many-to-many query to the targets of the query,
+ * grouped by vertex: the entries of vertex v are in the positions [offsets[v], offsets[v + 1]) of the target and dist
+ * arrays.
+ */
+template <class W>
+struct DistanceBuckets {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> target;
+    std::vector<W> dist;
+};
+
+/**
+ * @brief Dijkstra's algorithm limited to the vertices no further than a radius from the source, calling a function for
+ * each of them as they are settled, in order of distance.
+ * @param graph         CSR graph to search
+ * @param source        index of the source vertex
+ * @param radius        maximum distance of the settled vertices
+ * @param workspace     workspace used for the search
+ * @param visit         function receiving the index and the distance of each settled vertex
+ */
+template <class W, class Visit>
+void radiusSearchOverCsr(const BasicCsrGraph<W>& graph, uint32_t source, W radius, BasicSearchWorkspace<W>& workspace,
+                         const Visit& visit) {
+    workspace.reset(graph.numVertices());
+    IndexedPriorityQueue<W>& queue = workspace.queue;
+
+    workspace.setDist(source, 0, NO_VERTEX);
+    queue.insert(source);
+
+    while (!queue.empty()) {
+        uint32_t v = queue.extractMin();
+        W vDist = workspace.dist[v];
+        visit(v, vDist);
+
+        for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+            uint32_t w = graph.dest[e];
+            W newDist = WeightTraits<W>::add(vDist, graph.weight[e]);
+
+            if (newDist <= radius && workspace.getDist(w) > newDist) {
+                bool notInQueue = !workspace.reached(w);
+                workspace.setDist(w, newDist, v);
+
+                if (notInQueue) {
+                    queue.insert(w);
+                }
+                else {
+                    queue.decreaseKey(w);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief First phase of a many-to-many query: runs a backward search from each target and stores the distance from
+ * every vertex it settles to the target in the bucket of that vertex.
+ * @param backward      graph of the backward searches (the reverse graph, or the downward graph of a hierarchy)
+ * @param targets       indices of the target vertices
+ * @param radius        maximum distance of the backward searches
+ * @param workspace     workspace used for the searches
+ * @param buckets       filled with the distances, grouped by vertex
+ */
+template <class W>
+void fillDistanceBuckets(const BasicCsrGraph<W>& backward, const std::vector<uint32_t>& targets, W radius,
+                         BasicSearchWorkspace<W>& workspace, DistanceBuckets<W>& buckets) {
+    const uint32_t n = backward.numVertices();
+
+    // The entries are gathered in search order and then grouped by vertex with a counting sort
+    std::vector<uint32_t> entryVertex, entryTarget;
+    std::vector<W> entryDist;
+
+    for (uint32_t t = 0; t < targets.size(); ++t) {
+        radiusSearchOverCsr(backward, targets[t], radius, workspace, [&](uint32_t v, W dist) {
+            entryVertex.push_back(v);
+            entryTarget.push_back(t);
+            entryDist.push_back(dist);
+        });
+    }
+
+    buckets.offsets.assign(n + 1, 0);
+    for (uint32_t v : entryVertex) {
+        ++buckets.offsets[v + 1];
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+        buckets.offsets[v + 1] += buckets.offsets[v];
+    }
+
+    buckets.target.resize(entryVertex.size());
+    buckets.dist.resize(entryVertex.size());
+    std::vector<uint32_t> next(buckets.offsets.begin(), buckets.offsets.end() - 1);
+    for (size_t i = 0; i < entryVertex.size(); ++i) {
+        uint32_t position = next[entryVertex[i]]++;
+        buckets.target[position] = entryTarget[i];
+        buckets.dist[position] = entryDist[i];
+    }
+}
+
+/**
+ * @brief Combines a distance from a source to a vertex with the bucket of the vertex, improving the distances from the
+ * source to the targets.
+ */
+template <class W>
+void scanDistanceBucket(const DistanceBuckets<W>& buckets, uint32_t v, W dist, std::vector<W>& row) {
+    for (uint32_t i = buckets.offsets[v]; i < buckets.offsets[v + 1]; ++i) {
+        W candidate = WeightTraits<W>::add(dist, buckets.dist[i]);
+        if (candidate < row[buckets.target[i]]) {
+            row[buckets.target[i]] = candidate;
+        }
+    }
+}
+
+/**
+ * @brief Stores the distances from a source to the targets in the row of the output matrix, converted to its weight
+ * type M. Distances greater than the cutoff become infinite, as the searches of a many-to-many query may find paths
+ * longer than the cutoff which are not necessarily the shortest.
+ */
+template <class M, class W>
+void storeManyToManyRow(const std::vector<W>& row, W cutoff, std::vector<M>& output) {
+    output.resize(row.size());
+    for (size_t t = 0; t < row.size(); ++t) {
+        output[t] = row[t] > cutoff ? WeightTraits<M>::infinity() : convertWeight<M>(row[t]);
+    }
+}
+
+/**
+ * @brief Calculates the distances from a set of sources to a set of targets with bucket-based searches on a plain
+ * graph. Every shortest path no longer than the cutoff has an edge (a, b) where the distance from the source to a and
+ * the distance from b to the target are both within half of the cutoff, so each search only has to cover half of the
+ * cutoff: backward searches from the targets fill the buckets, and forward searches from the sources scan the buckets
+ * of the vertices they settle and of their neighbours. Without a cutoff, the backward searches are complete and each
+ * forward search only scans the buckets around its source.
+ * @param graph         CSR graph
+ * @param reverse       reverse of the CSR graph
+ * @param sources       indices of the source vertices
+ * @param targets       indices of the target vertices
+ * @param cutoff        maximum distance of interest
+ * @param workspace     workspace used for the searches
+ * @return              matrix with the distance from each source (row) to each target (column) in the weight type M,
+ * where distances that are unreachable or greater than the cutoff are infinite
+ */
+template <class M, class W>
+std::vector<std::vector<M>> manyToManyOverCsr(const BasicCsrGraph<W>& graph, const BasicCsrGraph<W>& reverse,
+        const std::vector<uint32_t>& sources, const std::vector<uint32_t>& targets, W cutoff,
+        BasicSearchWorkspace<W>& workspace) {
+    const W INF = WeightTraits<W>::infinity();
+    bool bounded = cutoff < INF;
+    W forwardRadius = bounded ? cutoff / 2 : 0;
+    W backwardRadius = bounded ? cutoff - forwardRadius : INF;
+
+    DistanceBuckets<W> buckets;
+    fillDistanceBuckets(reverse, targets, backwardRadius, workspace, buckets);
+
+    std::vector<std::vector<M>> distances(sources.size());
+    std::vector<W> row(targets.size());
+    for (size_t s = 0; s < sources.size(); ++s) {
+        std::fill(row.begin(), row.end(), INF);
+
+        radiusSearchOverCsr(graph, sources[s], forwardRadius, workspace, [&](uint32_t v, W dist) {
+            scanDistanceBucket(buckets, v, dist, row);
+            for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+                scanDistanceBucket(buckets, graph.dest[e], WeightTraits<W>::add(dist, graph.weight[e]), row);
+            }
+        });
+
+        storeManyToManyRow(row, cutoff, distances[s]);
+    }
+
+    return distances;
+}
+
+/**
+ * @brief Calculates the distances from a set of sources to a set of targets with bucket-based searches on a contraction
+ * hierarchy: downward backward searches from the targets fill the buckets, and upward forward searches from the
+ * sources scan the buckets of the vertices they settle, which always include the highest ranked vertex of each
+ * shortest path. Both searches only visit a small part of the graph, so the whole matrix costs little more than one
+ * small search per source and per target.
+ * @param hierarchy     contraction hierarchy of the graph
+ * @param sources       indices of the source vertices
+ * @param targets       indices of the target vertices
+ * @param cutoff        maximum distance of interest
+ * @param workspace     workspace used for the searches
+ * @return              matrix with the distance from each source (row) to each target (column) in the weight type M,
+ * where distances that are unreachable or greater than the cutoff are infinite
+ */
+template <class M>
+std::vector<std::vector<M>> manyToManyOverHierarchy(const ContractionHierarchy& hierarchy,
+        const std::vector<uint32_t>& sources, const std::vector<uint32_t>& targets, float cutoff,
+        SearchWorkspace& workspace) {
+    DistanceBuckets<float> buckets;
+    fillDistanceBuckets(hierarchy.getDownwardGraph(), targets, cutoff, workspace, buckets);
+
+    std::vector<std::vector<M>> distances(sources.size());
+    std::vector<float> row(targets.size());
+    for (size_t s = 0; s < sources.size(); ++s) {
+        std::fill(row.begin(), row.end(), WeightTraits<float>::infinity());
+
+        radiusSearchOverCsr(hierarchy.getUpwardGraph(), sources[s], cutoff, workspace, [&](uint32_t v, float dist) {
+            scanDistanceBucket(buckets, v, dist, row);
+        });
+
+        storeManyToManyRow(row, cutoff, distances[s]);
+    }
+
+    return distances;
+}
+
+/**
+ * @brief Calculates the distances from a set of sources to a set of targets, on the contraction hierarchy of the graph
+ * if one is given (it must have been built from this graph), and on the graph and its reverse otherwise.
+ * @return              matrix with the distance from each source (row) to each target (column) in the weight type M,
+ * where distances that are unreachable or greater than the cutoff are infinite
+ */
+template <class M>
+std::vector<std::vector<M>> manyToManyQuery(const ContractionHierarchy* hierarchy, const CsrGraph& graph,
+        const CsrGraph& reverse, const std::vector<uint32_t>& sources, const std::vector<uint32_t>& targets,
+        float cutoff, SearchWorkspace& workspace) {
+    if (hierarchy == nullptr)
+        return manyToManyOverCsr<M>(graph, reverse, sources, targets, cutoff, workspace);
+
+    if (!hierarchy->matches(graph)) {
+        std::cerr << "The hierarchy must match the graph" << std::endl;
+        exit(1);
+    }
+    return manyToManyOverHierarchy<M>(*hierarchy, sources, targets, cutoff, workspace);
+}
+
+/**
+ * @brief Version of manyToManyQuery for graphs whose weights are not floats, which have no contraction hierarchy.
+ */
+template <class M, class W>
+std::vector<std::vector<M>> manyToManyQuery(const ContractionHierarchy* hierarchy, const BasicCsrGraph<W>& graph,
+        const BasicCsrGraph<W>& reverse, const std::vector<uint32_t>& sources, const std::vector<uint32_t>& targets,
+        W cutoff, BasicSearchWorkspace<W>& workspace) {
+    if (hierarchy != nullptr) {
+        std::cerr << "Contraction hierarchies are only built on graphs with float weights" << std::endl;
+        exit(1);
+    }
+    return manyToManyOverCsr<M>(graph, reverse, sources, targets, cutoff, workspace);
+}
+
+#endif // MANY_TO_MANY_H
@@ -3,6 +3,9 @@
 
 #include <iostream>
 #include <algorithm>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
 
 int menu::optionsMenu(const std::string & title, const std::vector<std::string> & options, OPTION option) {
     if (title != "") {
@@ -135,7 +138,9 @@ MenuType menu::preferencesMenu(std::vector<float> & preferences) {
 }
 
 MenuType menu::algorithmsMenu(ReductionStepAlgorithm & reductionStepAlgorithm, CCTSPStepAlgorithm & cctspStepAlgorithm) {
-    int answer = optionsMenu("Select the Reduction Step Algorithm", {"Dijkstra", "Floyd-Warshall"}, menu::BACK);
+    int answer = optionsMenu("Select the Reduction Step Algorithm",
+                             {"Dijkstra", "Floyd-Warshall", "Contraction Hierarchies", "Many-to-Many", "Cached Rows"},
+                             menu::BACK);
     switch (answer) {
         case 0:
             return MAIN_MENU;
@@ -145,6 +150,15 @@ MenuType menu::algorithmsMenu(ReductionStepAlgorithm & reductionStepAlgorithm, C
         case 2:
             reductionStepAlgorithm = FLOYD_WARSHALL;
             break;
+        case 3:
+            reductionStepAlgorithm = CONTRACTION_HIERARCHIES;
+            break;
+        case 4:
+            reductionStepAlgorithm = MANY_TO_MANY;
+            break;
+        case 5:
+            reductionStepAlgorithm = CACHED_ROWS;
+            break;
         default:
             return MAIN_MENU;
     }
@@ -193,8 +207,11 @@ void menu::showPathOnGraphViewer(const std::vector<Vertex<char>*> & path,
         }
     }
 
+    // Sorted table of the indices of the points of interest, so each vertex of the path is looked up in logarithmic time
+    std::vector<uint32_t> poiIndex = pointOfInterestIndices(pointsOfInterest);
+    std::sort(poiIndex.begin(), poiIndex.end());
     for (auto v : path) {
-        if (std::find(pointsOfInterest.begin(), pointsOfInterest.end(), v) != pointsOfInterest.end()) {
+        if (std::binary_search(poiIndex.begin(), poiIndex.end(), v->getIndex())) {
             gv->setVertexColor(v->getInfo(), GRAY);
         }
     }
@@ -222,8 +239,10 @@ void menu::showPathOnGraphViewer(const std::vector<Vertex<PosInfo>*> & path,
         }
     }
 
+    std::vector<uint32_t> poiIndex = pointOfInterestIndices(pointsOfInterest);
+    std::sort(poiIndex.begin(), poiIndex.end());
     for (auto v : path) {
-        if (std::find(pointsOfInterest.begin(), pointsOfInterest.end(), v) != pointsOfInterest.end()) {
+        if (std::binary_search(poiIndex.begin(), poiIndex.end(), v->getIndex())) {
             gv->setVertexColor(v->getInfo().getId(), GRAY);
         }
     }
@@ -232,8 +251,14 @@ void menu::showPathOnGraphViewer(const std::vector<Vertex<PosInfo>*> & path,
 }
 
 
-unsigned int menu::selectVertex(const Graph<PosInfo>& graph) {
-    std::cout << "Enter a vertex id between 0 and " << graph.getVertexSet().size() - 1 << std::endl;
+/**
+ * @brief Asks for a vertex, either by its id or by a pair of coordinates, which are snapped to the closest vertex.
+ * @param vertexIndex   spatial index of the vertices of the graph, by vertex index
+ * @return              id of the vertex
+ */
+unsigned int menu::selectVertex(const Graph<PosInfo>& graph, const SpatialIndex& vertexIndex) {
+    std::cout << "Enter a vertex id between 0 and " << graph.getNumVertices() - 1
+              << ", or coordinates \"x y\" to use the closest vertex" << std::endl;
 
     std::string answerStr;
     unsigned int answer;
@@ -241,6 +266,15 @@ unsigned int menu::selectVertex(const Graph<PosInfo>& graph) {
     while (true) {
         std::cout << menu::INPUT;
         getline(std::cin, answerStr);
+
+        std::istringstream answerStream(answerStr);
+        float x, y;
+        if (answerStream >> x >> y) {
+            answer = graph.getVertex(vertexIndex.nearest(x, y))->getInfo().getId();
+            std::cout << "Closest vertex: " << answer << std::endl;
+            break;
+        }
+
         try {
             answer = stoul(answerStr);
         }
@@ -248,7 +282,7 @@ unsigned int menu::selectVertex(const Graph<PosInfo>& graph) {
             std::cerr << "Invalid unsigned int." << std::endl;
             continue;
         }
-        if ((answer >= 0) && (answer < graph.getVertexSet().size())) {
+        if ((answer >= 0) && (answer < graph.getNumVertices())) {
             break;
         }
     }
@@ -333,9 +367,50 @@ void initReportGraph(Graph<char>& graph, std::vector<Vertex<char>*>& pointsOfInt
     scores.push_back(2.0);
 }
 
+/**
+ * @brief Builds a spatial index of the positions of a list of vertices, where the id of each vertex is its position in
+ * the list.
+ */
+static SpatialIndex indexPositions(const std::vector<Vertex<PosInfo>*>& vertices) {
+    std::vector<float> x, y;
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        x.push_back(vertices[i]->getInfo().getX());
+        y.push_back(vertices[i]->getInfo().getY());
+        ids.push_back(i);
+    }
+    return SpatialIndex(x, y, ids);
+}
+
+/**
+ * @brief Summarizes the text files of a map by their sizes and modification times, so that a snapshot made from other
+ * versions of them is not used, even if an edit kept their sizes. Only the metadata of the files is read.
+ */
+static uint64_t textMapStamp(const std::string& filePath) {
+    uint64_t stamp = 14695981039346656037ULL;
+    auto mix = [&stamp](uint64_t value) {
+        stamp = (stamp ^ value) * 1099511628211ULL;
+    };
+
+    for (const char* name : {"nodes.txt", "edges.txt", "tags.txt"}) {
+        struct stat status;
+        if (stat((filePath + name).c_str(), &status) != 0) {
+            // Missing files also change the stamp
+            mix(UINT64_MAX);
+            continue;
+        }
+        mix(static_cast<uint64_t>(status.st_size));
+        mix(static_cast<uint64_t>(status.st_mtime));
+    }
+    return stamp;
+}
+
 MenuType menu::calculateTripMenu(const std::vector<float>& preferences,
                                  const ReductionStepAlgorithm & reductionStepAlgorithm,
                                  const CCTSPStepAlgorithm & cctspStepAlgorithm, const CityMap & map) {
+    static ThreadPool pool;
+    // Rows of the points of interest of each map, so trips on a map already visited need no reduction step searches
+    static std::map<std::string, DistanceRowCache> caches;
 
     if (map == REPORT) {
         Graph<char> graph;
@@ -344,8 +419,15 @@ MenuType menu::calculateTripMenu(const std::vector<float>& preferences,
 
         initReportGraph(graph, pointsOfInterest, scores);
 
-        std::vector<Vertex<char>*> path = mmpMethod(graph, pointsOfInterest, scores, 's', 'f',
-                                                    12, reductionStepAlgorithm, cctspStepAlgorithm);
+        // The report graph has no coordinates, so its searches and its prefilter are guided by the bounds of a few
+        // landmarks instead
+        graph.freeze();
+        Landmarks landmarks(graph.getCsr(), graph.getReverseCsr(), 4);
+
+        // The weights of the report graph are whole numbers, so the CCTSP step compares costs exactly in fixed point
+        std::vector<Vertex<char>*> path = mmpMethod<char, uint32_t>(graph, pointsOfInterest, scores, 's', 'f',
+                                                                    12, reductionStepAlgorithm, cctspStepAlgorithm,
+                                                                    &pool, nullptr, nullptr, nullptr, &landmarks);
 
         showPath(path);
 
@@ -362,21 +444,93 @@ MenuType menu::calculateTripMenu(const std::vector<float>& preferences,
         else if (map == GRID_8X8) filePath = "maps/8x8/";
         else filePath = "maps/16x16/";
 
-        parseVertexFile(filePath + "nodes.txt", graph);
-        parseEdgeFile(filePath + "edges.txt", graph, false);
-        parseTagsFile(filePath + "tags.txt", graph, pointsOfInterest, categories);
+        // Parsing the text files and computing every edge weight is much slower than loading the snapshot of the map,
+        // which is written the first time the map is used (and again with the rows of its points of interest, the first
+        // time they are used)
+        uint64_t stamp = textMapStamp(filePath);
+        GraphSnapshot snapshot;
+        bool fromSnapshot = snapshot.load(filePath + "map.snapshot") && snapshot.getSourceStamp() == stamp;
+        if (fromSnapshot) {
+            snapshot.toGraph(graph, pointsOfInterest, categories);
+        }
+        else {
+            parseVertexFile(filePath + "nodes.txt", graph);
+            parseEdgeFile(filePath + "edges.txt", graph, false);
+            parseTagsFile(filePath + "tags.txt", graph, pointsOfInterest, categories);
+        }
 
         std::vector<float> scores = calculateScores(categories, preferences);
 
+        // The hierarchy of each map is built once and saved next to it, as preprocessing is much slower than queries.
+        // Only the algorithms which run on it load (or build) it
+        graph.freeze();
+        ContractionHierarchy hierarchy;
+        const bool usesHierarchy = reductionStepAlgorithm == CONTRACTION_HIERARCHIES ||
+                                   reductionStepAlgorithm == MANY_TO_MANY;
+        if (usesHierarchy && (!hierarchy.load(filePath + "ch.bin") || !hierarchy.matches(graph.getCsr()))) {
+            hierarchy = ContractionHierarchy(graph.getCsr());
+            if (!hierarchy.save(filePath + "ch.bin")) {
+                std::cerr << "Could not save the contraction hierarchy of the map" << std::endl;
+            }
+        }
+
+        SpatialIndex vertexIndex = indexPositions(graph.getVertexSet());
+        SpatialIndex pointOfInterestIndex = indexPositions(pointsOfInterest);
+
         optionsMenu("Start vertex", {}, menu::NONE);
-        unsigned int start = selectVertex(graph);
+        unsigned int start = selectVertex(graph, vertexIndex);
         optionsMenu("Finish vertex", {}, menu::NONE);
-        unsigned int finish = selectVertex(graph);
+        unsigned int finish = selectVertex(graph, vertexIndex);
 
         float budget = getBudget();
 
-        std::vector<Vertex<PosInfo>*> path = mmpMethod(graph, pointsOfInterest, scores,
-                                                       PosInfo(start), PosInfo(finish), budget, reductionStepAlgorithm, cctspStepAlgorithm);
+        // The edge weights are euclidean distances, so a point of interest outside the ellipse with foci at the start
+        // and finish vertices is out of reach, and can be pruned without searching the graph (the budget is widened
+        // slightly, so rounding never prunes a point at its edge)
+        const PosInfo& startInfo = graph.findVertex(PosInfo(start))->getInfo();
+        const PosInfo& finishInfo = graph.findVertex(PosInfo(finish))->getInfo();
+        std::vector<uint32_t> nearby = pointOfInterestIndex.withinEllipse(startInfo.getX(), startInfo.getY(),
+                                                                          finishInfo.getX(), finishInfo.getY(),
+                                                                          budget * 1.0001f);
+        std::sort(nearby.begin(), nearby.end());
+
+        std::vector<Vertex<PosInfo>*> candidates;
+        std::vector<float> candidateScores;
+        for (uint32_t i : nearby) {
+            candidates.push_back(pointsOfInterest[i]);
+            candidateScores.push_back(scores[i]);
+        }
+
+        // The rows of the points of interest are only computed (or restored from the snapshot) when they are used
+        DistanceRowCache* cache = nullptr;
+        bool rowsBuilt = false;
+        if (reductionStepAlgorithm == CACHED_ROWS) {
+            cache = &caches[filePath];
+            std::vector<uint32_t> sources = pointOfInterestIndices(pointsOfInterest);
+            if (!cache->matches(graph.getCsr(), sources) && fromSnapshot) {
+                snapshot.toCache(*cache);
+            }
+            if (!cache->matches(graph.getCsr(), sources)) {
+                cache->build(graph.getCsr(), graph.getReverseCsr(), sources, &pool);
+                rowsBuilt = true;
+            }
+        }
+
+        // A snapshot loaded without rows is written again once they are built
+        if (!fromSnapshot || rowsBuilt) {
+            // Releases the mapping of the file about to be overwritten
+            snapshot = GraphSnapshot();
+            if (!GraphSnapshot::write(filePath + "map.snapshot", graph, pointsOfInterest, categories, stamp, cache)) {
+                std::cerr << "Could not save the snapshot of the map" << std::endl;
+            }
+        }
+
+        // The straight-line distance is also an admissible heuristic
+        std::vector<Vertex<PosInfo>*> path = mmpMethod<PosInfo>(graph, candidates, candidateScores,
+                                                                PosInfo(start), PosInfo(finish), budget,
+                                                                reductionStepAlgorithm, cctspStepAlgorithm,
+                                                                &pool, euclideanDistance,
+                                                                usesHierarchy ? &hierarchy : nullptr, cache);
 
         showPath(path);
 
@@ -5,7 +5,12 @@
 #include "parsing.h"
 #include "branchAndBound.h"
 #include "nearestNeighbour.h"
+#include "WeightTraits.h"
+#include "SpatialIndex.h"
+#include "GraphSnapshot.h"
 
+#include <algorithm>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -27,7 +32,11 @@ enum CityMap {
 
 enum ReductionStepAlgorithm {
     DIJKSTRA,
-    FLOYD_WARSHALL
+    FLOYD_WARSHALL,
+    CONTRACTION_HIERARCHIES,
+    MANY_TO_MANY,
+    // Reads the distances from the rows of the points of interest, computed once per map (see DistanceRowCache)
+    CACHED_ROWS
 };
 
 enum CCTSPStepAlgorithm {
@@ -65,63 +74,121 @@ namespace menu {
     void showPathOnGraphViewer(const std::vector<Vertex<PosInfo>*>& path,
             const std::vector<Vertex<PosInfo>*>& pointsOfInterest);
 
-    unsigned int selectVertex(const Graph<PosInfo>& graph);
+    unsigned int selectVertex(const Graph<PosInfo>& graph, const SpatialIndex& vertexIndex);
 
     float getBudget();
     std::vector<float> calculateScores(const std::vector<POICategory> & pointsOfInterestCategories,
             const std::vector<float>& preferences);
 }
 
-/** Reconstructs the full path from the cost-constrained TSP path. */
+/**
+ * Function receiving the information of two vertices and returning a lower bound of the distance between them, used to
+ * guide point to point searches (empty if no such bound is known for the graph).
+ */
 template<class T>
-std::vector<Vertex<T>*> reconstructPath(Graph<T>& graph, T start, T finish,
-                                        const std::vector<std::vector<float>>& adjMatrix, const std::vector<Vertex<T>*>& pointsOfInterest,
-                                        const std::vector<int>& tspPath) {
+using DistanceHeuristic = std::function<float(const T&, const T&)>;
 
-    std::vector<Vertex<T>*> path, pathFragment;
-    path.push_back(graph.findVertex(start));
-
-    graph.dijkstraShortestPath(start);
-
-    for (int i = 1; i < tspPath.size(); ++i) {
-        int idx = tspPath.at(i);
-
-        Vertex<T>* poi = pointsOfInterest.at(idx - 1);
-        Vertex<T>* v = poi;
-
-        pathFragment.clear();
-
-        do {
-            // We insert at the beginning to invert the order of the vertices
-            if (v->getPath() != nullptr)
-                pathFragment.insert(pathFragment.begin(), v);
-
-            v = v->getPath();
-        } while (v != nullptr);
-
-        path.insert(path.end(), pathFragment.begin(), pathFragment.end());
-
-        graph.dijkstraShortestPath(poi->getInfo());
+/**
+ * Calculates the shortest path between two vertices, using the contraction hierarchy of the graph if there is one, A*
+ * with the landmark bounds if there are landmarks, A* with the heuristic if one is available and a bidirectional
+ * Dijkstra search otherwise.
+ */
+template<class T>
+float pointToPointQuery(const Graph<T>& graph, const Vertex<T>* source, const Vertex<T>* target, float cutoff,
+                        const DistanceHeuristic<T>& heuristic, const ContractionHierarchy* hierarchy,
+                        const Landmarks* landmarks, SearchWorkspace& forward, SearchWorkspace& backward,
+                        std::vector<Vertex<T>*>* path = nullptr) {
+    if (hierarchy != nullptr) {
+        float dist = graph.contractionHierarchyQuery(*hierarchy, source, target, forward, backward, path);
+        if (dist > cutoff && path != nullptr) {
+            path->clear();
+        }
+        return dist > cutoff ? MAX_FLOAT : dist;
     }
+    if (landmarks != nullptr) {
+        return graph.altQuery(*landmarks, source, target, cutoff, forward, path);
+    }
+    if (heuristic) {
+        return graph.astar(source, target, heuristic, cutoff, forward, path);
+    }
+    return graph.bidirectionalDijkstra(source, target, cutoff, forward, backward, path);
+}
 
-    pathFragment.clear();
-    Vertex<T>* finishPtr = graph.findVertex(finish);
-
-    do {
-        // We insert at the beginning to invert the order of the vertices
-        if (finishPtr->getPath() != nullptr)
-            pathFragment.insert(pathFragment.begin(), finishPtr);
+/**
+ * Reconstructs the full path from the cost-constrained TSP path. If the reduction step kept its shortest paths (the
+ * trees of its searches, one per row of the adjacency matrix, the predecessor matrix of the Floyd-Warshall algorithm,
+ * or the cached rows of the points of interest), the legs are unpacked from them, and otherwise each leg is searched.
+ */
+template<class T, class W>
+std::vector<Vertex<T>*> reconstructPath(const Graph<T>& graph, T start, T finish,
+                                        const std::vector<std::vector<W>>& adjMatrix, const std::vector<Vertex<T>*>& pointsOfInterest,
+                                        const std::vector<int>& tspPath, const DistanceHeuristic<T>& heuristic = nullptr,
+                                        const ContractionHierarchy* hierarchy = nullptr,
+                                        const PredecessorTrees* trees = nullptr,
+                                        const FlatMatrix<int32_t>* floydWarshallPath = nullptr,
+                                        const DistanceRowCache* cache = nullptr,
+                                        const Landmarks* landmarks = nullptr) {
+    SearchWorkspace forward, backward;
+
+    std::vector<Vertex<T>*> path, leg;
+    std::vector<uint32_t> indexLeg;
+    Vertex<T>* legStart = graph.findVertex(start);
+    path.push_back(legStart);
+
+    // An empty TSP path visits no point of interest, so the path is just the leg from the start to the finish vertex
+    const size_t numLegs = std::max<size_t>(tspPath.size(), 1);
+
+    for (size_t i = 1; i <= numLegs; ++i) {
+        Vertex<T>* legEnd = i < tspPath.size() ? pointsOfInterest.at(tspPath.at(i) - 1) : graph.findVertex(finish);
+
+        // The leg starts at the source of the row of the matrix given by the previous element of the TSP path (the
+        // row of the start vertex is the first one)
+        size_t row = tspPath.empty() ? 0 : tspPath.at(i - 1);
+        bool unpacked = false;
+        if (trees != nullptr) {
+            unpacked = trees->path(row, legEnd->getIndex(), forward, indexLeg);
+        }
+        else if (cache != nullptr) {
+            // Legs from a point of interest follow its forward row, and the leg from the start vertex follows the
+            // reverse row of the point of interest it leads to (legs whose vertex has no row are searched)
+            size_t cacheRow = row > 0 ? cache->findRow(legStart->getIndex()) :
+                    i < tspPath.size() ? cache->findRow(legEnd->getIndex()) : DistanceRowCache::NO_ROW;
+            if (cacheRow != DistanceRowCache::NO_ROW) {
+                unpacked = row > 0 ? cache->forwardPath(cacheRow, legEnd->getIndex(), indexLeg) :
+                        cache->reversePath(cacheRow, legStart->getIndex(), indexLeg);
+            }
+        }
 
-        finishPtr = finishPtr->getPath();
-    } while (finishPtr != nullptr);
+        if (unpacked) {
+            leg.clear();
+            for (uint32_t v : indexLeg) {
+                leg.push_back(graph.getVertex(v));
+            }
+        }
+        else if (floydWarshallPath != nullptr) {
+            graph.floydWarshallPath(*floydWarshallPath, legStart, legEnd, leg);
+        }
+        else {
+            pointToPointQuery(graph, legStart, legEnd, MAX_FLOAT, heuristic, hierarchy, landmarks, forward, backward,
+                              &leg);
+        }
 
+        if (!leg.empty()) {
+            // The first vertex of the leg is the last one of the path so far
+            path.insert(path.end(), leg.begin() + 1, leg.end());
+        }
 
-    path.insert(path.end(), pathFragment.begin(), pathFragment.end());
+        legStart = legEnd;
+    }
 
     return path;
 }
 
-template<class T>
+/**
+ * Solves a trip request. The reduction step builds the adjacency matrix of the CCTSP step directly with weights of
+ * type W (see WeightTraits).
+ */
+template<class T, class W = float>
 std::vector<Vertex<T>*> mmpMethod(
         Graph<T> & graph,
         const std::vector<Vertex<T>*>& pointsOfInterest,
@@ -130,15 +197,40 @@ std::vector<Vertex<T>*> mmpMethod(
         const T& finish,
         float budget,
         const ReductionStepAlgorithm & reductionStepAlgorithm,
-        const CCTSPStepAlgorithm & cctspStepAlgorithm
+        const CCTSPStepAlgorithm & cctspStepAlgorithm,
+        ThreadPool * pool = nullptr,
+        const DistanceHeuristic<T>& heuristic = nullptr,
+        const ContractionHierarchy * hierarchy = nullptr,
+        const DistanceRowCache * cache = nullptr,
+        const Landmarks * landmarks = nullptr
 ) {
-    graph.dijkstraShortestPath(start);
+    graph.freeze();
+
+    // Without a precomputed hierarchy, one is built for this request if it was chosen for the reduction step
+    ContractionHierarchy localHierarchy;
+    if (hierarchy == nullptr && reductionStepAlgorithm == CONTRACTION_HIERARCHIES) {
+        localHierarchy = ContractionHierarchy(graph.getCsr());
+        hierarchy = &localHierarchy;
+    }
+
+    // Stale landmarks are dropped once for the whole request, instead of failing one of its queries
+    if (landmarks != nullptr && !landmarks->matches(graph.getCsr())) {
+        landmarks = nullptr;
+    }
 
+    Vertex<T>* startPtr = graph.findVertex(start);
     Vertex<T>* finishPtr = graph.findVertex(finish);
 
+    if (startPtr == nullptr) {
+        return std::vector<Vertex<T>*>();
+    }
+
     // Check if there is a solution (a path from start to finish with cost no greater than budget)
     if (finishPtr != nullptr) {
-        if (finishPtr->getDist() > budget) {
+        SearchWorkspace forward, backward;
+
+        if (pointToPointQuery<T>(graph, startPtr, finishPtr, budget, heuristic, hierarchy, landmarks, forward,
+                                 backward) > budget) {
             std::cout << "There isn't a path from start to finish with cost no greater than the budget." << std::endl;
             return std::vector<Vertex<T> *>();
         }
@@ -147,33 +239,67 @@ std::vector<Vertex<T>*> mmpMethod(
         return std::vector<Vertex<T>*>();
     }
 
-    Vertex<T>* startPtr = graph.findVertex(start);
+    // Points of interest outside the budget ellipse can never be visited, so they are left out of the reduction and
+    // CCTSP steps
+    std::vector<Vertex<T>*> candidates;
+    std::vector<float> candidateScores;
+    for (size_t i : graph.feasiblePointsOfInterest(pointsOfInterest, startPtr, finishPtr, budget, cache,
+                                                     landmarks)) {
+        candidates.push_back(pointsOfInterest[i]);
+        candidateScores.push_back(scores[i]);
+    }
 
-    std::vector<std::vector<float>> adj;
-    switch (reductionStepAlgorithm) {
+    std::vector<std::vector<W>> adj;
+    // Shortest path trees of the reduction step, when it keeps them, so the final path needs no further searches
+    PredecessorTrees trees;
+    FlatMatrix<int32_t> floydWarshallPath;
+    // Cached rows replace the searches of the reduction step altogether, but graphs without them fall back to Dijkstra
+    ReductionStepAlgorithm algorithm = reductionStepAlgorithm == CACHED_ROWS && cache == nullptr ?
+            DIJKSTRA : reductionStepAlgorithm;
+    switch (algorithm) {
         case DIJKSTRA:
-            adj = graph.generateAdjacencyMatrixWithDijkstra(pointsOfInterest, startPtr, finishPtr);
+            adj = pool != nullptr ?
+                    graph.template generateAdjacencyMatrixWithDijkstra<W>(candidates, startPtr, finishPtr, *pool,
+                                                                          budget, &trees) :
+                    graph.template generateAdjacencyMatrixWithDijkstra<W>(candidates, startPtr, finishPtr, budget,
+                                                                          &trees);
             break;
         case FLOYD_WARSHALL:
-            adj = graph.generateAdjacencyMatrixWithFloydWarshall(pointsOfInterest, startPtr, finishPtr);
+            adj = graph.template generateAdjacencyMatrixWithFloydWarshall<W>(candidates, startPtr, finishPtr,
+                                                                             pool, &floydWarshallPath);
+            break;
+        case CONTRACTION_HIERARCHIES:
+            adj = graph.template generateAdjacencyMatrixWithContractionHierarchy<W>(candidates, startPtr,
+                                                                                    finishPtr, *hierarchy);
+            break;
+        case MANY_TO_MANY:
+            adj = graph.template generateAdjacencyMatrixWithManyToMany<W>(candidates, startPtr, finishPtr, budget,
+                                                                          hierarchy);
+            break;
+        case CACHED_ROWS:
+            adj = graph.template generateAdjacencyMatrixFromCache<W>(candidates, startPtr, finishPtr, *cache);
             break;
         default:
             break;
     }
 
+    W weightBudget = WeightTraits<W>::fromFloat(budget);
+
     std::vector<int> tspPath;
     switch (cctspStepAlgorithm) {
         case BRANCH_AND_BOUND:
-            tspPath = branchAndBound(adj, scores, budget);
+            tspPath = branchAndBound(adj, candidateScores, weightBudget);
             break;
         case NEAREST_NEIGHBOUR:
-            tspPath = nearestNeighbour(adj, scores, budget);
+            tspPath = nearestNeighbour(adj, candidateScores, weightBudget);
             break;
         default:
             break;
     }
 
-    return reconstructPath(graph, start, finish, adj, pointsOfInterest, tspPath);
+    return reconstructPath(graph, start, finish, adj, candidates, tspPath, heuristic, hierarchy,
+                           trees.size() > 0 ? &trees : nullptr,
+                           algorithm == FLOYD_WARSHALL ? &floydWarshallPath : nullptr, cache, landmarks);
 }
 
 template <class T>
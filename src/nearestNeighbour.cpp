@@ -1,16 +1,18 @@
 #include <iostream>
 #include "nearestNeighbour.h"
+#include "WeightTraits.h"
 
 using namespace std;
 
+template <class W>
 std::vector<int>
-nearestNeighbour(const std::vector<std::vector<float>> &adjMatrix, const std::vector<float> &scores, float budget) {
+nearestNeighbour(const std::vector<std::vector<W>> &adjMatrix, const std::vector<float> &scores, W budget) {
     int mSize = adjMatrix.size();
     if (scores.size() != mSize - 1) {
         cerr << "Invalid args" << endl;
         exit(1);
     }
-    for (const vector<float> &i : adjMatrix) {
+    for (const vector<W> &i : adjMatrix) {
         if (i.size() != mSize) {
             cerr << "Invalid args" << endl;
             exit(1);
@@ -20,7 +22,7 @@ nearestNeighbour(const std::vector<std::vector<float>> &adjMatrix, const std::ve
 
     vector<int> path;
     vector<int> unusedVertices;
-    float pathCost = 0;
+    W pathCost = 0;
     float score = 0;
 
     path.reserve(adjMatrix.size());
@@ -39,10 +41,10 @@ nearestNeighbour(const std::vector<std::vector<float>> &adjMatrix, const std::ve
             int index = unusedVertices[i];
 
             int lastPathIndex = path[path.size() - 1];
-            float newCost = pathCost - adjMatrix[lastPathIndex][0]
-                            + adjMatrix[lastPathIndex][index] + adjMatrix[index][0];
+            W newCost = WeightTraits<W>::add(WeightTraits<W>::add(pathCost - adjMatrix[lastPathIndex][0],
+                            adjMatrix[lastPathIndex][index]), adjMatrix[index][0]);
 
-            float ratio = scores[index - 1] / adjMatrix[lastPathIndex][index];
+            float ratio = scores[index - 1] / WeightTraits<W>::toFloat(adjMatrix[lastPathIndex][index]);
 
             if (newCost <= budget && ratio > bestRatio) {
                 bestRatio = ratio;
@@ -56,8 +58,8 @@ nearestNeighbour(const std::vector<std::vector<float>> &adjMatrix, const std::ve
             int index = unusedVertices[bestUnusedPathIndex];
 
             int lastPathIndex = path[path.size() - 1];
-            float newCost = pathCost - adjMatrix[lastPathIndex][0]
-                            + adjMatrix[lastPathIndex][index] + adjMatrix[index][0];
+            W newCost = WeightTraits<W>::add(WeightTraits<W>::add(pathCost - adjMatrix[lastPathIndex][0],
+                            adjMatrix[lastPathIndex][index]), adjMatrix[index][0]);
 
             float newScore = score + scores[index - 1];
 
@@ -68,7 +70,13 @@ nearestNeighbour(const std::vector<std::vector<float>> &adjMatrix, const std::ve
         }
     }
 
-    cout << "Path score: " << score << " | Path cost: " << pathCost << endl;
+    cout << "Path score: " << score << " | Path cost: " << WeightTraits<W>::toFloat(pathCost) << endl;
 
     return path;
 }
+
+template std::vector<int> nearestNeighbour(const std::vector<std::vector<float>> &, const std::vector<float> &, float);
+template std::vector<int> nearestNeighbour(const std::vector<std::vector<double>> &, const std::vector<float> &,
+                                           double);
+template std::vector<int> nearestNeighbour(const std::vector<std::vector<uint32_t>> &, const std::vector<float> &,
+                                           uint32_t);
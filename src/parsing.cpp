@@ -1,10 +1,12 @@
 
 #include "parsing.h"
 #include "PosInfo.h"
+#include "MappedFile.h"
 
 #include <iostream>
-#include <fstream>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
 const float EARTH_RADIUS_M = 6371000;
 
@@ -12,11 +14,6 @@ float degreesToRadians(float degrees) {
     return M_PI * degrees / 180.0;
 }
 
-/**
- * @brief Calculates the distance between two points using the haversine formula. Interprets x and y as x and
- * y, respectively.
- * @return  distance between the points, in meters
- */
 float haversineDistance(const PosInfo& from, const PosInfo& to) {
     float fromLatRad = degreesToRadians(from.getX());
     float fromLongRad = degreesToRadians(from.getY());
@@ -30,86 +27,382 @@ float haversineDistance(const PosInfo& from, const PosInfo& to) {
             cos(fromLatRad) * cos(toLatRad) * pow(sin(longitudeDiff / 2), 2)));
 }
 
-/**
- * @brief Calculates the euclidean distance between two points
- */
 float euclideanDistance(const PosInfo& from, const PosInfo& to) {
     return sqrt(pow(from.getX() - to.getX(), 2) + pow(from.getY() - to.getY(), 2));
 }
 
 
+namespace {
+
+/**
+ * Cursor over the lines of a text file held in memory. Numbers are parsed by hand, so reading neither copies the text
+ * nor depends on the locale. Blank lines are skipped, and problems are reported with the path and the line number.
+ */
+class LineScanner {
+public:
+    LineScanner(const std::string& path, const MappedFile& file) :
+            path(path), next(file.data()), end(file.data() + file.size()) {}
+
+    bool nextLine();
+    void skipLine();
+    bool atLineEnd();
+    bool atWordEnd() const;
+    bool expect(char c);
+    template<class U>
+    bool readUnsigned(U& value);
+    bool readFloat(float& value);
+    bool readWord(std::string& word);
+
+    void report(const std::string& message) const;
+private:
+    const std::string& path;
+    // Start of the lines not read yet, and end of the file
+    const char* next;
+    const char* end;
+    // Position in the current line, and its end
+    const char* pos = nullptr;
+    const char* lineEnd = nullptr;
+    size_t line = 0;
+
+    void skipSpaces();
+};
+
+/**
+ * @brief Moves to the next line with any text on it.
+ * @return  false if the end of the file was reached
+ */
+bool LineScanner::nextLine() {
+    while (next < end) {
+        const char* newline = static_cast<const char*>(std::memchr(next, '\n', end - next));
+        pos = next;
+        lineEnd = newline != nullptr ? newline : end;
+        next = newline != nullptr ? newline + 1 : end;
+        ++line;
+
+        skipSpaces();
+        if (pos < lineEnd)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Ignores the rest of the current line.
+ */
+void LineScanner::skipLine() {
+    pos = lineEnd;
+}
+
+/**
+ * @brief Checks that nothing but spaces is left on the current line.
+ */
+bool LineScanner::atLineEnd() {
+    skipSpaces();
+    return pos == lineEnd;
+}
+
+/**
+ * @brief Checks that the next character is a space or the end of the line.
+ */
+bool LineScanner::atWordEnd() const {
+    return pos == lineEnd || *pos == ' ' || *pos == '\t' || *pos == '\r';
+}
+
+/**
+ * @brief Consumes a given character, after any spaces, if it is the next one on the line.
+ */
+bool LineScanner::expect(char c) {
+    skipSpaces();
+    if (pos == lineEnd || *pos != c)
+        return false;
+
+    ++pos;
+    return true;
+}
+
+/**
+ * @brief Reads an unsigned integer, failing if there are no digits or if it does not fit in the type.
+ */
+template<class U>
+bool LineScanner::readUnsigned(U& value) {
+    skipSpaces();
+
+    const char* start = pos;
+    U result = 0;
+    while (pos < lineEnd && *pos >= '0' && *pos <= '9') {
+        unsigned digit = *pos - '0';
+        if (result > (std::numeric_limits<U>::max() - digit) / 10)
+            return false;
+        result = result * 10 + digit;
+        ++pos;
+    }
+
+    if (pos == start)
+        return false;
+
+    value = result;
+    return true;
+}
+
+/**
+ * @brief Reads a decimal number, with an optional sign, fractional part and exponent. The first 19 significant digits
+ * are accumulated exactly and scaled by a power of ten in double precision, so the result is within rounding of what
+ * strtof would give.
+ */
+bool LineScanner::readFloat(float& value) {
+    static const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+                                           1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const int MAX_DIGITS = 19;
+
+    skipSpaces();
+
+    bool negative = false;
+    if (pos < lineEnd && (*pos == '-' || *pos == '+')) {
+        negative = *pos == '-';
+        ++pos;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int numDigits = 0;
+    bool anyDigits = false;
+
+    // Digits past the first 19 significant ones only shift the decimal point of the integer part
+    for (; pos < lineEnd && *pos >= '0' && *pos <= '9'; ++pos) {
+        anyDigits = true;
+        if (numDigits < MAX_DIGITS) {
+            mantissa = mantissa * 10 + (*pos - '0');
+            numDigits += mantissa != 0;
+        }
+        else {
+            ++exponent;
+        }
+    }
+    if (pos < lineEnd && *pos == '.') {
+        for (++pos; pos < lineEnd && *pos >= '0' && *pos <= '9'; ++pos) {
+            anyDigits = true;
+            if (numDigits < MAX_DIGITS) {
+                mantissa = mantissa * 10 + (*pos - '0');
+                numDigits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+    if (!anyDigits)
+        return false;
+
+    if (pos < lineEnd && (*pos == 'e' || *pos == 'E')) {
+        ++pos;
+        bool negativeExponent = false;
+        if (pos < lineEnd && (*pos == '-' || *pos == '+')) {
+            negativeExponent = *pos == '-';
+            ++pos;
+        }
+        unsigned explicitExponent;
+        if (!readUnsigned(explicitExponent) || explicitExponent > 1000)
+            return false;
+        exponent += negativeExponent ? -static_cast<int>(explicitExponent) : static_cast<int>(explicitExponent);
+    }
+
+    double result = static_cast<double>(mantissa);
+    unsigned magnitude = exponent < 0 ? -exponent : exponent;
+    double scale = magnitude <= 22 ? POWERS_OF_TEN[magnitude] : std::pow(10.0, magnitude);
+    result = exponent < 0 ? result / scale : result * scale;
+
+    value = static_cast<float>(negative ? -result : result);
+    return std::isfinite(value);
+}
+
+/**
+ * @brief Reads a run of characters up to the next space.
+ */
+bool LineScanner::readWord(std::string& word) {
+    skipSpaces();
+
+    const char* start = pos;
+    while (!atWordEnd()) {
+        ++pos;
+    }
+
+    word.assign(start, pos);
+    return pos != start;
+}
+
+void LineScanner::report(const std::string& message) const {
+    std::cerr << path << ":" << line << ": " << message << std::endl;
+}
+
+void LineScanner::skipSpaces() {
+    while (pos < lineEnd && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+        ++pos;
+    }
+}
+
+/**
+ * @brief Reads the header line of a map file, with the number of entries that follow.
+ */
+bool readCount(LineScanner& scanner, size_t& count) {
+    if (scanner.nextLine() && scanner.readUnsigned(count) && scanner.atLineEnd())
+        return true;
+
+    scanner.report("expected the number of entries");
+    return false;
+}
+
+/**
+ * @brief Reports a file with fewer entries than its header announced.
+ */
+void reportTruncated(const std::string& path, size_t expected, size_t found) {
+    std::cerr << path << ": expected " << expected << " entries, found " << found << std::endl;
+}
+
+} // namespace
+
 void parseVertexFile(const std::string& path, Graph<PosInfo>& graph) {
-    std::ifstream ifs;
-    ifs.open(path);
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return;
+    }
+
+    LineScanner scanner(path, file);
 
-    size_t numVertices;
-    ifs >> numVertices;
+    size_t numVertices = 0;
+    if (!readCount(scanner, numVertices))
+        return;
 
-    std::string line;
     unsigned int id;
     float latitude, longitude;
 
-    char c;
-
-    for (size_t i = 0; i < numVertices; ++i) {
-        ifs >> c >> id >> c >> latitude >> c >> longitude >> c;
-
-        graph.addVertex(PosInfo(id, latitude, longitude));
+    graph.reserveVertices(numVertices);
+    size_t i = 0;
+    for (; i < numVertices && scanner.nextLine(); ++i) {
+        if (!scanner.expect('(') || !scanner.readUnsigned(id) || !scanner.expect(',') ||
+            !scanner.readFloat(latitude) || !scanner.expect(',') || !scanner.readFloat(longitude) ||
+            !scanner.expect(')') || !scanner.atLineEnd()) {
+            scanner.report("malformed vertex, expected (id, x, y)");
+        }
+        else if (!graph.addVertex(PosInfo(id, latitude, longitude))) {
+            scanner.report("duplicate vertex " + std::to_string(id));
+        }
     }
 
-    ifs.close();
+    if (i < numVertices) {
+        reportTruncated(path, numVertices, i);
+    }
 }
 
 void parseEdgeFile(const std::string& path, Graph<PosInfo>& graph, bool haversine) {
-    std::ifstream ifs;
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return;
+    }
 
-    ifs.open(path);
+    LineScanner scanner(path, file);
 
-    size_t numEdges;
-    ifs >> numEdges;
+    size_t numEdges = 0;
+    if (!readCount(scanner, numEdges))
+        return;
 
-    std::string line;
     unsigned int idSource, idDest;
-    char c;
 
-    for (size_t i = 0; i < numEdges; ++i) {
-        ifs >> c >> idSource >> c >> idDest >> c;
+    // The edges are read before being added, so the adjacency lists can be sized to their final degrees
+    std::vector<std::pair<Vertex<PosInfo>*, Vertex<PosInfo>*>> edges;
+    edges.reserve(numEdges);
+    std::vector<size_t> outDegrees(graph.getNumVertices(), 0);
+
+    size_t i = 0;
+    for (; i < numEdges && scanner.nextLine(); ++i) {
+        if (!scanner.expect('(') || !scanner.readUnsigned(idSource) || !scanner.expect(',') ||
+            !scanner.readUnsigned(idDest) || !scanner.expect(')') || !scanner.atLineEnd()) {
+            scanner.report("malformed edge, expected (source, destination)");
+            continue;
+        }
 
         Vertex<PosInfo>* sourcePtr = graph.findVertex(idSource);
         Vertex<PosInfo>* destPtr = graph.findVertex(idDest);
+        if (sourcePtr == nullptr || destPtr == nullptr) {
+            scanner.report("edge to unknown vertex " + std::to_string(sourcePtr == nullptr ? idSource : idDest));
+            continue;
+        }
+
+        edges.push_back({sourcePtr, destPtr});
+        ++outDegrees[sourcePtr->getIndex()];
+    }
+
+    if (i < numEdges) {
+        reportTruncated(path, numEdges, i);
+    }
+
+    graph.reserveEdges(outDegrees);
+    for (const std::pair<Vertex<PosInfo>*, Vertex<PosInfo>*>& edge : edges) {
+        Vertex<PosInfo>* sourcePtr = edge.first;
+        Vertex<PosInfo>* destPtr = edge.second;
 
         float dist = haversine ? haversineDistance(sourcePtr->getInfo(), destPtr->getInfo()) :
                 euclideanDistance(sourcePtr->getInfo(), destPtr->getInfo());
 
-        graph.addEdge(idSource, idDest, dist);
+        graph.addEdge(sourcePtr, destPtr, dist);
     }
-
-    ifs.close();
 }
 
 void parseTagsFile(const std::string& path, Graph<PosInfo>& graph,
                    std::vector<Vertex<PosInfo>*>& pointsOfInterest, std::vector<POICategory>& categories) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return;
+    }
 
-    std::ifstream ifs(path);
+    LineScanner scanner(path, file);
 
-    size_t numTags;
-    ifs >> numTags;
+    size_t numTags = 0;
+    if (!readCount(scanner, numTags))
+        return;
 
     size_t numEntries;
-    std::string line;
-    POICategory category;
+    std::string tag;
     unsigned int id;
 
     for (size_t i = 0; i < numTags; ++i) {
-        ifs >> line;
-        category = categoryStringMap.at(line);
+        // Without the tag and the number of its entries, the rest of the file cannot be made sense of
+        if (!scanner.nextLine() || !scanner.readWord(tag) || !scanner.atLineEnd()) {
+            scanner.report("expected a tag");
+            return;
+        }
 
-        ifs >> numEntries;
+        // Entries of unknown tags are still read, but not added
+        std::map<std::string, POICategory>::const_iterator category = categoryStringMap.find(tag);
+        if (category == categoryStringMap.end()) {
+            scanner.report("unknown tag " + tag);
+        }
+
+        if (!readCount(scanner, numEntries))
+            return;
+
+        // The ids are usually one per line, but any spaces may separate them
+        size_t j = 0;
+        for (; j < numEntries && (!scanner.atLineEnd() || scanner.nextLine()); ++j) {
+            if (!scanner.readUnsigned(id) || !scanner.atWordEnd()) {
+                scanner.report("malformed entry, expected a vertex id");
+                scanner.skipLine();
+                continue;
+            }
+
+            Vertex<PosInfo>* vertex = graph.findVertex(id);
+            if (vertex == nullptr) {
+                scanner.report("tag of unknown vertex " + std::to_string(id));
+            }
+            else if (category != categoryStringMap.end()) {
+                pointsOfInterest.push_back(vertex);
+                categories.push_back(category->second);
+            }
+        }
 
-        for (size_t j = 0; j < numEntries; ++j) {
-            ifs >> id;
-            pointsOfInterest.push_back(graph.findVertex(id));
-            categories.push_back(category);
+        if (j < numEntries) {
+            reportTruncated(path, numEntries, j);
+            return;
         }
     }
 }
@@ -34,14 +34,29 @@ const std::map<std::string, POICategory> categoryStringMap = {
 };
 
 /**
- * @brief Parses a text file containing vertex information
+ * @brief Calculates the distance between two points using the haversine formula. Interprets x and y as latitude and
+ * longitude, respectively.
+ * @return  distance between the points, in meters
+ */
+float haversineDistance(const PosInfo& from, const PosInfo& to);
+
+/**
+ * @brief Calculates the euclidean distance between two points
+ */
+float euclideanDistance(const PosInfo& from, const PosInfo& to);
+
+/**
+ * @brief Parses a text file containing vertex information: a line with the number of vertices, followed by a line
+ * "(id, x, y)" per vertex. Malformed lines and duplicate ids are reported on the standard error and skipped.
  * @param path      path to the file
  * @param graph     reference to the graph where the vertices will be inserted
  */
 void parseVertexFile(const std::string& path, Graph<PosInfo>& graph);
 
 /**
- * @brief Parses a text file containing edge information
+ * @brief Parses a text file containing edge information: a line with the number of edges, followed by a line
+ * "(source id, destination id)" per edge. Malformed lines and edges of unknown vertices are reported on the standard
+ * error and skipped.
  * @param path          path to the file
  * @param graph         reference to a graph where the edges will be inserted
  * @param haversine     if true, uses the haversine distance formula to calculate edge weight (set this to true if the
@@ -50,7 +65,9 @@ void parseVertexFile(const std::string& path, Graph<PosInfo>& graph);
 void parseEdgeFile(const std::string& path, Graph<PosInfo>& graph, bool haversine = true);
 
 /**
- * Parses a tags file, filling a POI vector and its respective categories
+ * Parses a tags file, filling a POI vector and its respective categories. The file has a line with the number of tags,
+ * and then, for each tag, a line with the tag, a line with the number of its vertices, and a line with the id of each
+ * of them. Malformed lines, unknown tags and unknown vertices are reported on the standard error and skipped.
  * @param path              path to the file
  * @param graph             reference to the graph with the points of interest
  * @param pointsOfInterest  reference to the POI vector
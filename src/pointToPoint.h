@@ -0,0 +1,189 @@
+#ifndef POINT_TO_POINT_H
+#define POINT_TO_POINT_H
+
+#include "CsrGraph.h"
+#include "SearchWorkspace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Calculates the shortest path between two vertices with the A* algorithm, which settles vertices by their
+ * distance from the source plus a lower bound of their distance to the target.
+ *
+ * Vertices are reopened if a shorter path to them is found after they are settled, so the result is exact with any
+ * admissible heuristic, and no vertex is reopened if the heuristic is also consistent (as straight-line distances are).
+ * @param graph         CSR graph (or view) to search
+ * @param source        index of the source vertex
+ * @param target        index of the target vertex
+ * @param heuristic     function returning a lower bound of the distance from a vertex (given by its index) to the target
+ * @param cutoff        paths longer than this are ignored
+ * @param workspace     workspace where the distances and predecessors of the vertices are left
+ * @return              distance from the source to the target, or infinity if it is greater than the cutoff
+ */
+template <class Csr, class Heuristic, class W>
+W astarOverCsr(const Csr& graph, uint32_t source, uint32_t target, const Heuristic& heuristic, W cutoff,
+               BasicSearchWorkspace<W>& workspace) {
+    const uint32_t n = graph.numVertices();
+
+    workspace.reset(n);
+    workspace.priority.resize(n);
+    std::vector<W>& priority = workspace.priority;
+    IndexedPriorityQueue<W>& queue = workspace.queue;
+    queue.reset(priority.data(), n);
+
+    workspace.setDist(source, 0, NO_VERTEX);
+    priority[source] = heuristic(source);
+    queue.insert(source);
+
+    while (!queue.empty()) {
+        uint32_t v = queue.extractMin();
+        if (v == target) {
+            queue.clear();
+            return workspace.dist[v];
+        }
+
+        W vDist = workspace.dist[v];
+
+        for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+            uint32_t w = graph.dest[e];
+            W newDist = WeightTraits<W>::add(vDist, graph.weight[e]);
+
+            if (workspace.getDist(w) > newDist) {
+                W newPriority = WeightTraits<W>::add(newDist, heuristic(w));
+                if (newPriority > cutoff)
+                    continue;
+
+                workspace.setDist(w, newDist, v);
+                priority[w] = newPriority;
+
+                if (queue.contains(w)) {
+                    queue.decreaseKey(w);
+                }
+                else {
+                    queue.insert(w);
+                }
+            }
+        }
+    }
+
+    return WeightTraits<W>::infinity();
+}
+
+/**
+ * @brief Relaxes the edges of a vertex in one direction of a bidirectional search, updating the best path found if an
+ * edge reaches a vertex already reached by the search in the other direction.
+ */
+template <class Csr, class W>
+void bidirectionalStep(const Csr& graph, BasicSearchWorkspace<W>& workspace, const BasicSearchWorkspace<W>& other,
+                       W& best, uint32_t& meeting) {
+    uint32_t v = workspace.queue.extractMin();
+    W vDist = workspace.dist[v];
+
+    for (uint32_t e = graph.edgesBegin(v); e < graph.edgesEnd(v); ++e) {
+        uint32_t w = graph.dest[e];
+        W newDist = WeightTraits<W>::add(vDist, graph.weight[e]);
+
+        if (workspace.getDist(w) > newDist) {
+            bool notInQueue = !workspace.reached(w);
+            workspace.setDist(w, newDist, v);
+
+            if (notInQueue) {
+                workspace.queue.insert(w);
+            }
+            else {
+                workspace.queue.decreaseKey(w);
+            }
+
+            if (other.reached(w) && WeightTraits<W>::add(newDist, other.getDist(w)) < best) {
+                best = WeightTraits<W>::add(newDist, other.getDist(w));
+                meeting = w;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Calculates the shortest path between two vertices with a bidirectional Dijkstra search, alternating between
+ * a forward search from the source and a backward search from the target (over the reverse graph), and stopping when
+ * no path through the unsettled vertices can be shorter than the best one found.
+ * @param graph         CSR graph (or view) to search
+ * @param reverse       CSR graph with every edge of the graph reversed
+ * @param source        index of the source vertex
+ * @param target        index of the target vertex
+ * @param cutoff        paths longer than this are ignored
+ * @param forward       workspace of the forward search
+ * @param backward      workspace of the backward search (its predecessors are successors in the original graph)
+ * @param meeting       set to the index of a vertex of the shortest path where both searches met (NO_VERTEX if none)
+ * @return              distance from the source to the target, or infinity if it is greater than the cutoff
+ */
+template <class Csr, class W>
+W bidirectionalDijkstraOverCsr(const Csr& graph, const Csr& reverse, uint32_t source, uint32_t target, W cutoff,
+                               BasicSearchWorkspace<W>& forward, BasicSearchWorkspace<W>& backward,
+                               uint32_t& meeting) {
+    const W INF = WeightTraits<W>::infinity();
+
+    forward.reset(graph.numVertices());
+    backward.reset(graph.numVertices());
+
+    forward.setDist(source, 0, NO_VERTEX);
+    forward.queue.insert(source);
+    backward.setDist(target, 0, NO_VERTEX);
+    backward.queue.insert(target);
+
+    W best = source == target ? 0 : INF;
+    meeting = source == target ? source : NO_VERTEX;
+
+    while (!forward.queue.empty() || !backward.queue.empty()) {
+        W forwardTop = forward.queue.empty() ? INF : forward.dist[forward.queue.top()];
+        W backwardTop = backward.queue.empty() ? INF : backward.dist[backward.queue.top()];
+
+        // Every path not found yet is at least as long as the sum of the minimum keys of both queues
+        W bound = WeightTraits<W>::add(forwardTop, backwardTop);
+        if (bound >= best || bound > cutoff)
+            break;
+
+        if (forwardTop <= backwardTop) {
+            bidirectionalStep(graph, forward, backward, best, meeting);
+        }
+        else {
+            bidirectionalStep(reverse, backward, forward, best, meeting);
+        }
+    }
+
+    forward.queue.clear();
+    backward.queue.clear();
+
+    if (best > cutoff) {
+        meeting = NO_VERTEX;
+        return INF;
+    }
+    return best;
+}
+
+/**
+ * @brief Builds the path found by a bidirectional search, joining the forward path from the source to the meeting
+ * vertex with the backward path from the meeting vertex to the target.
+ * @return      indices of the vertices of the path, from the source to the target (empty if there is no path)
+ */
+template <class W>
+std::vector<uint32_t> bidirectionalPath(const BasicSearchWorkspace<W>& forward, const BasicSearchWorkspace<W>& backward,
+                                        uint32_t meeting) {
+    std::vector<uint32_t> path;
+    if (meeting == NO_VERTEX)
+        return path;
+
+    for (uint32_t v = meeting; v != NO_VERTEX; v = forward.getPred(v)) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+
+    for (uint32_t v = backward.getPred(meeting); v != NO_VERTEX; v = backward.getPred(v)) {
+        path.push_back(v);
+    }
+
+    return path;
+}
+
+#endif // POINT_TO_POINT_H
@@ -3,12 +3,15 @@
 
 #include <chrono>
 #include <iostream>
+#include <memory>
 
-void generateRandomGraph(Graph<int>& graph, std::vector<Vertex<int>*>& pointsOfInterest, int numVertices) {
+template <class W>
+void generateRandomGraph(Graph<int, W>& graph, std::vector<Vertex<int, W>*>& pointsOfInterest, int numVertices) {
     srand(time(nullptr));
 
     const double POI_CHANCE = 0.1;
 
+    graph.reserveVertices(numVertices);
     for (int i = 0; i < numVertices; ++i) {
         graph.addVertex(i);
     }
@@ -27,10 +30,10 @@ void generateRandomGraph(Graph<int>& graph, std::vector<Vertex<int>*>& pointsOfI
         if (v1 != v2) {
             bool edgeExists = false;
 
-            Vertex<int>* startPtr = graph.findVertex(v1);
-            Vertex<int>* endPtr = graph.findVertex(v2);
+            Vertex<int, W>* startPtr = graph.findVertex(v1);
+            Vertex<int, W>* endPtr = graph.findVertex(v2);
 
-            const std::vector<Edge<int>>& adj = startPtr->getAdj();
+            const EdgeList<int, W>& adj = startPtr->getAdj();
 
             for (auto edge : adj) {
                 if (edge.getDest() == endPtr) {
@@ -41,20 +44,62 @@ void generateRandomGraph(Graph<int>& graph, std::vector<Vertex<int>*>& pointsOfI
 
             if (!edgeExists) {
                 float weight = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 5.0;
-                graph.addEdge(v1, v2, weight);
+                graph.addEdge(v1, v2, WeightTraits<W>::fromFloat(weight));
             }
         }
     }
 }
 
+template void generateRandomGraph(Graph<int, float>&, std::vector<Vertex<int, float>*>&, int);
+template void generateRandomGraph(Graph<int, uint32_t>&, std::vector<Vertex<int, uint32_t>*>&, int);
+
+
+/**
+ * @brief Runs dijkstraShortestPath with a given priority queue from the start vertex and from every point of interest
+ * (the searches of the reduction step, without a cutoff), returning the time taken in microseconds.
+ */
+template <class Queue>
+static long long timeDijkstraSearches(Graph<int>& graph, const std::vector<Vertex<int>*>& pointsOfInterest, int start,
+                                      Queue& queue) {
+    auto t1 = std::chrono::high_resolution_clock::now();
+    graph.dijkstraShortestPath(start, queue);
+    for (const Vertex<int>* POI : pointsOfInterest) {
+        graph.dijkstraShortestPath(POI->getInfo(), queue);
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+}
 
 void testReductionStepAlgorithms() {
-    std::cout << "numVertices, time Dijkstra (microseconds), time FW (microseconds)" << std::endl;
+    ThreadPool pool;
+
+    // Floyd-Warshall is measured with 1, 2, 4, ... threads, up to the number of hardware threads
+    std::vector<unsigned> fwThreadCounts;
+    for (unsigned threads = 1; threads < pool.size(); threads *= 2) {
+        fwThreadCounts.push_back(threads);
+    }
+    fwThreadCounts.push_back(pool.size());
+
+    std::vector<std::unique_ptr<ThreadPool>> fwPools;
+    for (unsigned threads : fwThreadCounts) {
+        fwPools.push_back(std::unique_ptr<ThreadPool>(new ThreadPool(threads)));
+    }
+
+    std::cout << "numVertices, time Dijkstra (microseconds), time parallel Dijkstra (microseconds), "
+                 "time many-to-many (microseconds), time searches binary heap (microseconds), "
+                 "time searches radix heap (microseconds), time searches Dial buckets (microseconds)";
+    for (unsigned threads : fwThreadCounts) {
+        std::cout << ", time FW " << threads << " threads (microseconds)";
+    }
+    std::cout << std::endl;
 
     const size_t NUM_ITERS = 5;
 
     for (int n = 10; n <= 1000; n += 10) {
-        unsigned long long usDij = 0, usFW = 0;
+        unsigned long long usDij = 0, usParDij = 0, usManyToMany = 0;
+        unsigned long long usBinaryHeap = 0, usRadixHeap = 0, usDial = 0;
+        std::vector<unsigned long long> usFW(fwThreadCounts.size(), 0);
 
         for (int i = 0; i < NUM_ITERS; ++i) {
             Graph<int> graph;
@@ -73,20 +118,52 @@ void testReductionStepAlgorithms() {
             graph.generateAdjacencyMatrixWithDijkstra(pointsOfInterest, graph.findVertex(start), graph.findVertex(finish));
             auto t2Dij = std::chrono::high_resolution_clock::now();
 
-            auto t1FW = std::chrono::high_resolution_clock::now();
-            graph.generateAdjacencyMatrixWithFloydWarshall(pointsOfInterest, graph.findVertex(start), graph.findVertex(finish));
-            auto t2FW = std::chrono::high_resolution_clock::now();
+            auto t1ParDij = std::chrono::high_resolution_clock::now();
+            graph.generateAdjacencyMatrixWithDijkstra(pointsOfInterest, graph.findVertex(start), graph.findVertex(finish),
+                                                      pool);
+            auto t2ParDij = std::chrono::high_resolution_clock::now();
+
+            auto t1ManyToMany = std::chrono::high_resolution_clock::now();
+            graph.generateAdjacencyMatrixWithManyToMany(pointsOfInterest, graph.findVertex(start),
+                                                        graph.findVertex(finish));
+            auto t2ManyToMany = std::chrono::high_resolution_clock::now();
+
+            graph.freeze();
+            IndexedPriorityQueue<float> binaryHeap;
+            RadixHeap<float> radixHeap;
+            DialQueue<float> dial(graph.getCsr());
+            usBinaryHeap += timeDijkstraSearches(graph, pointsOfInterest, start, binaryHeap);
+            usRadixHeap += timeDijkstraSearches(graph, pointsOfInterest, start, radixHeap);
+            usDial += timeDijkstraSearches(graph, pointsOfInterest, start, dial);
+
+            for (size_t t = 0; t < fwThreadCounts.size(); ++t) {
+                auto t1FW = std::chrono::high_resolution_clock::now();
+                graph.generateAdjacencyMatrixWithFloydWarshall(pointsOfInterest, graph.findVertex(start),
+                                                               graph.findVertex(finish), fwPools[t].get());
+                auto t2FW = std::chrono::high_resolution_clock::now();
+
+                usFW[t] += std::chrono::duration_cast<std::chrono::microseconds>(t2FW - t1FW).count();
+            }
 
             long long deltaDij = std::chrono::duration_cast<std::chrono::microseconds>(t2Dij - t1Dij).count();
-            long long deltaFW = std::chrono::duration_cast<std::chrono::microseconds>(t2FW - t1FW).count();
+            long long deltaParDij = std::chrono::duration_cast<std::chrono::microseconds>(t2ParDij - t1ParDij).count();
+            long long deltaManyToMany = std::chrono::duration_cast<std::chrono::microseconds>(
+                    t2ManyToMany - t1ManyToMany).count();
 
             usDij += deltaDij;
-            usFW += deltaFW;
+            usParDij += deltaParDij;
+            usManyToMany += deltaManyToMany;
         }
 
         usDij /= NUM_ITERS;
-        usFW /= NUM_ITERS;
+        usParDij /= NUM_ITERS;
+        usManyToMany /= NUM_ITERS;
 
-        std::cout << n << ", " << usDij << ", " << usFW << std::endl;
+        std::cout << n << ", " << usDij << ", " << usParDij << ", " << usManyToMany << ", "
+                  << usBinaryHeap / NUM_ITERS << ", " << usRadixHeap / NUM_ITERS << ", " << usDial / NUM_ITERS;
+        for (unsigned long long us : usFW) {
+            std::cout << ", " << us / NUM_ITERS;
+        }
+        std::cout << std::endl;
     }
 }
\ No newline at end of file
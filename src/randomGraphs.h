@@ -6,12 +6,14 @@
 
 /**
  * @brief Generates a random graph with a given amount of vertices, that should, in theory, be relatively sparse.
+ * Instantiated for float and fixed point (uint32_t) weights.
  *
  * @param graph
  * @param pointsOfInterest
  * @param numVertices
  */
-void generateRandomGraph(Graph<int>& graph, std::vector<Vertex<int>*>& pointsOfInterest, int numVertices);
+template <class W>
+void generateRandomGraph(Graph<int, W>& graph, std::vector<Vertex<int, W>*>& pointsOfInterest, int numVertices);
 
 void testReductionStepAlgorithms();
 